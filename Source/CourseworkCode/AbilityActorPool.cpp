@@ -0,0 +1,243 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "AbilityActorPool.h"
+#include "CourseworkCode.h"
+#include "FuryShot.h"
+#include "Curveball.h"
+#include "SageCube.h"
+#include "Engine/World.h"
+#include "GameFramework/Pawn.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Pool Hits"), STAT_AbilityPoolHits, STATGROUP_CourseworkCode);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Pool Misses"), STAT_AbilityPoolMisses, STATGROUP_CourseworkCode);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Pool Overflows"), STAT_AbilityPoolOverflows, STATGROUP_CourseworkCode);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Pooled Actors"), STAT_AbilityPooledActors, STATGROUP_CourseworkCode);
+
+DEFINE_LOG_CATEGORY_STATIC(LogAbilityPool, Log, All);
+
+// sets default pool sizes, these can be overridden in DefaultGame.ini
+UAbilityActorPool::UAbilityActorPool()
+{
+	furyShotPoolSize = 128;
+	furyShotPrewarmCount = 32;
+	curveballPoolSize = 8;
+	curveballPrewarmCount = 2;
+	sageCubePoolSize = 24;
+	sageCubePrewarmCount = 6;
+	defaultPoolSize = 16;
+
+	poolHits = 0;
+	poolMisses = 0;
+	poolOverflows = 0;
+}
+
+// logs the pool statistics once the world is torn down
+void UAbilityActorPool::Deinitialize()
+{
+	UE_LOG(LogAbilityPool, Log, TEXT("Ability actor pool: %d hits, %d misses, %d overflows"), poolHits, poolMisses, poolOverflows);
+
+	for (const TPair<UClass*, FPooledActorList>& pool : pools)
+	{
+		DEC_DWORD_STAT_BY(STAT_AbilityPooledActors, pool.Value.inactiveActors.Num());
+	}
+
+	pools.Empty();
+
+	Super::Deinitialize();
+}
+
+// returns the maximum number of inactive actors kept for the class
+int32 UAbilityActorPool::GetPoolSize(UClass* actorClass) const
+{
+	if (actorClass->IsChildOf(AFuryShot::StaticClass()))
+	{
+		return furyShotPoolSize;
+	}
+
+	if (actorClass->IsChildOf(ACurveball::StaticClass()))
+	{
+		return curveballPoolSize;
+	}
+
+	if (actorClass->IsChildOf(ASageCube::StaticClass()))
+	{
+		return sageCubePoolSize;
+	}
+
+	return defaultPoolSize;
+}
+
+// returns the number of actors spawned ahead of time for the class
+int32 UAbilityActorPool::GetPrewarmCount(UClass* actorClass) const
+{
+	if (actorClass->IsChildOf(AFuryShot::StaticClass()))
+	{
+		return furyShotPrewarmCount;
+	}
+
+	if (actorClass->IsChildOf(ACurveball::StaticClass()))
+	{
+		return curveballPrewarmCount;
+	}
+
+	if (actorClass->IsChildOf(ASageCube::StaticClass()))
+	{
+		return sageCubePrewarmCount;
+	}
+
+	return 0;
+}
+
+int32 UAbilityActorPool::getInactiveCount(TSubclassOf<AActor> actorClass) const
+{
+	const FPooledActorList* pool = pools.Find(actorClass);
+
+	return pool != NULL ? pool->inactiveActors.Num() : 0;
+}
+
+// spawns actors and puts them straight into the pool
+// so the first shots of a match don't pay for spawning
+void UAbilityActorPool::Prewarm(TSubclassOf<AActor> actorClass)
+{
+	UWorld* const World = GetWorld();
+	if (actorClass == NULL || World == NULL)
+	{
+		return;
+	}
+
+	const int32 prewarmCount = FMath::Min(GetPrewarmCount(actorClass), GetPoolSize(actorClass));
+
+	FActorSpawnParameters prewarmSpawnParams;
+	prewarmSpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+	while (getInactiveCount(actorClass) < prewarmCount)
+	{
+		AActor* actor = World->SpawnActor<AActor>(actorClass, FTransform::Identity, prewarmSpawnParams);
+		if (actor == NULL)
+		{
+			break;
+		}
+
+		ReleaseActor(actor);
+	}
+}
+
+// takes the most recently released actor of the class out of the pool
+// if none are available a new actor gets spawned instead
+AActor* UAbilityActorPool::AcquireActor(TSubclassOf<AActor> actorClass, const FTransform& spawnTransform, const FActorSpawnParameters& spawnParams)
+{
+	UWorld* const World = GetWorld();
+	if (actorClass == NULL || World == NULL)
+	{
+		return NULL;
+	}
+
+	FPooledActorList* pool = pools.Find(actorClass);
+
+	while (pool != NULL && pool->inactiveActors.Num() > 0)
+	{
+		AActor* actor = pool->inactiveActors.Pop(false);
+		DEC_DWORD_STAT(STAT_AbilityPooledActors);
+
+		// skip actors that were destroyed while inside the pool, e.g. by a level change
+		if (actor == NULL || actor->IsPendingKillPending())
+		{
+			continue;
+		}
+
+		poolHits++;
+		INC_DWORD_STAT(STAT_AbilityPoolHits);
+
+		// place the actor and set who fired or placed it
+		actor->SetActorTransform(spawnTransform, false, nullptr, ETeleportType::ResetPhysics);
+		actor->SetOwner(spawnParams.Owner);
+		actor->Instigator = spawnParams.Instigator;
+
+		// bring the actor back into the world
+		actor->SetActorHiddenInGame(false);
+		actor->SetActorEnableCollision(true);
+		actor->SetActorTickEnabled(actor->PrimaryActorTick.bStartWithTickEnabled);
+
+		// let the actor reset its own state
+		if (IPooledAbilityActor* pooledActor = Cast<IPooledAbilityActor>(actor))
+		{
+			pooledActor->OnAcquiredFromPool();
+		}
+
+		return actor;
+	}
+
+	poolMisses++;
+	INC_DWORD_STAT(STAT_AbilityPoolMisses);
+
+	return World->SpawnActor<AActor>(actorClass, spawnTransform, spawnParams);
+}
+
+// hides the actor and stops it from ticking or colliding while it waits in the pool
+void UAbilityActorPool::DeactivateActor(AActor* actor)
+{
+	if (IPooledAbilityActor* pooledActor = Cast<IPooledAbilityActor>(actor))
+	{
+		pooledActor->OnReleasedToPool();
+	}
+
+	actor->SetActorHiddenInGame(true);
+	actor->SetActorEnableCollision(false);
+	actor->SetActorTickEnabled(false);
+}
+
+// hands the actor back to the pool for its class
+void UAbilityActorPool::ReleaseActor(AActor* actor)
+{
+	if (actor == NULL || actor->IsPendingKillPending())
+	{
+		return;
+	}
+
+	FPooledActorList& pool = pools.FindOrAdd(actor->GetClass());
+
+	// the actor may already have been released this frame, e.g. hit and lifespan expiring together
+	if (pool.inactiveActors.Contains(actor))
+	{
+		return;
+	}
+
+	// destroy the actor if the pool is already full
+	if (pool.inactiveActors.Num() >= GetPoolSize(actor->GetClass()))
+	{
+		poolOverflows++;
+		INC_DWORD_STAT(STAT_AbilityPoolOverflows);
+
+		actor->Destroy();
+		return;
+	}
+
+	DeactivateActor(actor);
+
+	pool.inactiveActors.Add(actor);
+	INC_DWORD_STAT(STAT_AbilityPooledActors);
+}
+
+// releases the actor to its world's pool
+// falls back to destroying it if the world has no pool
+void UAbilityActorPool::ReleaseOrDestroy(AActor* actor)
+{
+	if (actor == NULL)
+	{
+		return;
+	}
+
+	UWorld* const World = actor->GetWorld();
+	UAbilityActorPool* pool = World != NULL ? World->GetSubsystem<UAbilityActorPool>() : NULL;
+
+	if (pool != NULL)
+	{
+		pool->ReleaseActor(actor);
+	}
+
+	else
+	{
+		actor->Destroy();
+	}
+}
@@ -0,0 +1,138 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/Interface.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "GameFramework/Actor.h"
+#include "AbilityActorPool.generated.h"
+
+class APawn;
+
+UINTERFACE(MinimalAPI, meta = (CannotImplementInterfaceInBlueprint))
+class UPooledAbilityActor : public UInterface
+{
+	GENERATED_BODY()
+};
+
+/** reset hooks implemented by every actor that can be recycled by the ability actor pool */
+class COURSEWORKCODE_API IPooledAbilityActor
+{
+	GENERATED_BODY()
+
+public:
+
+	// called when a pooled actor is taken back out of the pool
+	// should put the actor back into the state it would have straight after spawning
+	virtual void OnAcquiredFromPool() = 0;
+
+	// called when the actor is handed back to the pool
+	// should stop any movement, timers or effects the actor still has running
+	virtual void OnReleasedToPool() = 0;
+};
+
+/** list of inactive actors of a single class waiting to be reused */
+USTRUCT()
+struct FPooledActorList
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	TArray<AActor*> inactiveActors;
+};
+
+/**
+ * World subsystem that pre-warms and recycles the ability actors (Fury Shots, Curveballs and Sage Cubes)
+ * so that firing and placing abilities doesn't construct and garbage collect a new actor every time
+ */
+UCLASS(config=Game)
+class COURSEWORKCODE_API UAbilityActorPool : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	UAbilityActorPool();
+
+	virtual void Deinitialize() override;
+
+	// spawns inactive actors of the given class until the configured pre-warm count is reached
+	void Prewarm(TSubclassOf<AActor> actorClass);
+
+	// takes an actor of the given class out of the pool and places it at the transform
+	// spawns a new actor if the pool has none left
+	AActor* AcquireActor(TSubclassOf<AActor> actorClass, const FTransform& spawnTransform, const FActorSpawnParameters& spawnParams);
+
+	template<typename T>
+	T* Acquire(TSubclassOf<T> actorClass, const FTransform& spawnTransform, const FActorSpawnParameters& spawnParams)
+	{
+		return Cast<T>(AcquireActor(actorClass, spawnTransform, spawnParams));
+	}
+
+	// hands an actor back to the pool
+	// the actor is destroyed instead if the pool for its class is already full
+	void ReleaseActor(AActor* actor);
+
+	// releases the actor to its world's pool, or destroys it if there is no pool available
+	static void ReleaseOrDestroy(AActor* actor);
+
+	// getters for the pool statistics
+
+	// number of acquires served by a pooled actor
+	int32 getPoolHits() const { return poolHits; }
+
+	// number of acquires that had to spawn a new actor
+	int32 getPoolMisses() const { return poolMisses; }
+
+	// number of releases that had to destroy the actor because the pool was full
+	int32 getPoolOverflows() const { return poolOverflows; }
+
+	// number of inactive actors of the given class
+	int32 getInactiveCount(TSubclassOf<AActor> actorClass) const;
+
+protected:
+
+	/** maximum number of inactive Fury Shots kept alive */
+	UPROPERTY(config)
+	int32 furyShotPoolSize;
+
+	/** number of Fury Shots spawned ahead of time */
+	UPROPERTY(config)
+	int32 furyShotPrewarmCount;
+
+	/** maximum number of inactive Curveballs kept alive */
+	UPROPERTY(config)
+	int32 curveballPoolSize;
+
+	/** number of Curveballs spawned ahead of time */
+	UPROPERTY(config)
+	int32 curveballPrewarmCount;
+
+	/** maximum number of inactive Sage Cubes kept alive */
+	UPROPERTY(config)
+	int32 sageCubePoolSize;
+
+	/** number of Sage Cubes spawned ahead of time */
+	UPROPERTY(config)
+	int32 sageCubePrewarmCount;
+
+	/** maximum number of inactive actors kept alive for any other class */
+	UPROPERTY(config)
+	int32 defaultPoolSize;
+
+	/** inactive actors sorted by their class */
+	UPROPERTY()
+	TMap<UClass*, FPooledActorList> pools;
+
+	// finds the pool size and pre-warm count configured for the class
+	int32 GetPoolSize(UClass* actorClass) const;
+	int32 GetPrewarmCount(UClass* actorClass) const;
+
+	// hides the actor and turns off its collision and ticking
+	void DeactivateActor(AActor* actor);
+
+	int32 poolHits;
+	int32 poolMisses;
+	int32 poolOverflows;
+};
@@ -3,3 +3,8 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "Stats/Stats.h"
+
+// stat group shared by the gameplay systems of this module
+// view in game with "stat CourseworkCode"
+DECLARE_STATS_GROUP(TEXT("CourseworkCode"), STATGROUP_CourseworkCode, STATCAT_Advanced);
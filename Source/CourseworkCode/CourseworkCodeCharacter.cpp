@@ -5,6 +5,12 @@
 #include "Curveball.h"
 #include "SageWall.h"
 #include "FuryShot.h"
+#include "SageCube.h"
+#include "AbilityActorPool.h"
+#include "FuryShotSimulation.h"
+#include "FirePipeline.h"
+#include "FireInputTimestamps.h"
+#include "FlashEffectComponent.h"
 #include "Animation/AnimInstance.h"
 #include "Camera/CameraComponent.h"
 #include "Components/CapsuleComponent.h"
@@ -13,6 +19,8 @@
 #include "Runtime/CoreUObject/Public/UObject/ConstructorHelpers.h"
 #include "HeadMountedDisplayFunctionLibrary.h"
 #include "Engine/Engine.h"
+#include "Engine/LocalPlayer.h"
+#include "GameFramework/PlayerController.h"
 #include "TimerManager.h"
 #include "Kismet/GameplayStatics.h"
 #include "Kismet/KismetMathLibrary.h"
@@ -40,7 +48,7 @@ ACourseworkCodeCharacter::ACourseworkCodeCharacter()
 	isPlacingWall = false;
 	isRotatingWall = false;
 	isFuryActivated = false;
-	isShooting = false;
+	useFuryShotSimulation = false;
 
 	// fire rates for the gun
 	furyFireRate = 0.1f;
@@ -49,6 +57,9 @@ ACourseworkCodeCharacter::ACourseworkCodeCharacter()
 	// fury shot ability length
 	furyFireAbilityLength = 10.0f;
 
+	// only back-date fire input from a clock much finer than a frame, this can be overridden in DefaultGame.ini
+	maxFireInputTimestampResolution = 0.002f;
+
 	// Create a CameraComponent	
 	FirstPersonCameraComponent = CreateDefaultSubobject<UCameraComponent>(TEXT("FirstPersonCamera"));
 	FirstPersonCameraComponent->SetupAttachment(GetCapsuleComponent());
@@ -115,6 +126,9 @@ ACourseworkCodeCharacter::ACourseworkCodeCharacter()
 	VR_MuzzleLocation->SetRelativeLocation(FVector(0.000004, 53.999992, 10.000000));
 	VR_MuzzleLocation->SetRelativeRotation(FRotator(0.0f, 90.0f, 0.0f));		// Counteract the rotation of the VR gun model.
 
+	// create the flash effect, which replaces the flash timeline in the character blueprint
+	FlashEffect = CreateDefaultSubobject<UFlashEffectComponent>(TEXT("FlashEffect"));
+
 	// Uncomment the following line to turn motion controllers on by default:
 	//bUsingMotionControllers = true;
 }
@@ -153,7 +167,13 @@ bool ACourseworkCodeCharacter::getIsFuryActivated()
 
 void ACourseworkCodeCharacter::setIsFuryActivated(bool val)
 {
-	isFuryActivated = val;
+	if (isFuryActivated != val)
+	{
+		isFuryActivated = val;
+
+		// let any listeners such as fury shots in flight know the state has changed
+		OnFuryStateChanged.Broadcast(isFuryActivated);
+	}
 }
 
 
@@ -178,6 +198,54 @@ void ACourseworkCodeCharacter::BeginPlay()
 		VR_Gun->SetHiddenInGame(true, true);
 		Mesh1P->SetHiddenInGame(false, true);
 	}
+
+	// start the automatic fire at the standard fire rate
+	fireScheduler.SetFireInterval(isFuryActivated ? furyFireRate : autoFireRate, GetWorld()->GetTimeSeconds());
+
+	// spawn the ability actors ahead of time so the first uses don't hitch
+	UAbilityActorPool* pool = GetWorld()->GetSubsystem<UAbilityActorPool>();
+	if (pool != NULL)
+	{
+		pool->Prewarm(FuryShotClass);
+		pool->Prewarm(CurveballClass);
+
+		// walls made of instanced segments don't use sage cube actors
+		if (SageWallClass != NULL && !SageWallClass->GetDefaultObject<ASageWall>()->getUseInstancedSegments())
+		{
+			pool->Prewarm(SageWallClass->GetDefaultObject<ASageWall>()->SageCubeClass);
+		}
+	}
+}
+
+// stops recording fire input times once the character is removed
+void ACourseworkCodeCharacter::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (fireInputTimestamps.IsValid())
+	{
+		fireInputTimestamps->Unregister();
+	}
+
+	fireInputTimestamps.Reset();
+
+	Super::EndPlay(EndPlayReason);
+}
+
+// fires any shots that became due since the last frame while the fire button is held
+
+void ACourseworkCodeCharacter::Tick(float DeltaSeconds)
+{
+	Super::Tick(DeltaSeconds);
+
+	if (fireScheduler.IsFiring())
+	{
+		FireDueShots();
+	}
+
+	// the controller handles input before the character ticks, so any times left over weren't used by a binding
+	if (fireInputTimestamps.IsValid())
+	{
+		fireInputTimestamps->Reset();
+	}
 }
 
 //////////////////////////////////////////////////////////////////////////
@@ -194,6 +262,17 @@ void ACourseworkCodeCharacter::SetupPlayerInputComponent(class UInputComponent*
 
 	// Bind fire event
 
+	// record when the fire button is pressed within the frame, so shots aren't held back to the frame they are handled in
+	// keyboard and mouse messages belong to one local player, so only that player's character records them
+	const APlayerController* playerController = Cast<APlayerController>(GetController());
+	const ULocalPlayer* localPlayer = playerController != NULL ? playerController->GetLocalPlayer() : NULL;
+
+	if (!fireInputTimestamps.IsValid() && localPlayer != NULL && FFireInputTimestamps::IsSupported(maxFireInputTimestampResolution) && FFireInputTimestamps::IsKeyboardUser(localPlayer->GetControllerId()))
+	{
+		fireInputTimestamps = MakeShareable(new FFireInputTimestamps(TEXT("Fire")));
+		fireInputTimestamps->Register();
+	}
+
 	// Shooting
 	PlayerInputComponent->BindAction("Fire", IE_Pressed, this, &ACourseworkCodeCharacter::OnFireAuto);
 
@@ -238,7 +317,7 @@ void ACourseworkCodeCharacter::SetupPlayerInputComponent(class UInputComponent*
 	// "turn" handles devices that provide an absolute delta, such as a mouse.
 	// "turnrate" is for devices that we choose to treat as a rate of change, such as an analog joystick
 	
-	PlayerInputComponent->BindAxis("Turn", this, &APawn::AddControllerYawInput);
+	PlayerInputComponent->BindAxis("Turn", this, &ACourseworkCodeCharacter::Turn);
 	
 	
 	
@@ -342,8 +421,14 @@ void ACourseworkCodeCharacter::CurveballFlashRight()
 			FActorSpawnParameters CurveballSpawnParams;
 			CurveballSpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
 
-			// Spawn the Curveball actor based on retrieved location and rotation variables
-			World->SpawnActor<ACurveball>(CurveballClass, SpawnLocation, SpawnRotation, CurveballSpawnParams);
+			// take a Curveball from the pool based on retrieved location and rotation variables
+			UAbilityActorPool* pool = World->GetSubsystem<UAbilityActorPool>();
+			ACurveball* curveball = pool->Acquire<ACurveball>(CurveballClass, FTransform(SpawnRotation, SpawnLocation), CurveballSpawnParams);
+
+			if (curveball != NULL)
+			{
+				curveball->Throw(false);
+			}
 		}
 	}
 
@@ -370,17 +455,20 @@ void ACourseworkCodeCharacter::CurveballFlashLeft()
 			const FRotator SpawnRotation = Curveball_SpawnLocation->GetComponentRotation();
 			const FVector SpawnLocation = Curveball_SpawnLocation->GetComponentLocation();
 
-			// as this Curveball is going left, a transform was created to set the Y-Scale to -1
-			// this allows for a quick and easy change from throwing it right
-
-			const FTransform SpawnTransform(SpawnRotation,SpawnLocation, FVector(1.0f, -1.0f, 1.0f));
-
 			// Spawn collision parameter handle
 			FActorSpawnParameters CurveballSpawnParams;
 			CurveballSpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
 
-			// Spawn the Curveball actor based on retrieved transform variables
-			World->SpawnActor<ACurveball>(CurveballClass, SpawnTransform, CurveballSpawnParams);
+			// take a Curveball from the pool based on retrieved location and rotation variables
+			UAbilityActorPool* pool = World->GetSubsystem<UAbilityActorPool>();
+			ACurveball* curveball = pool->Acquire<ACurveball>(CurveballClass, FTransform(SpawnRotation, SpawnLocation), CurveballSpawnParams);
+
+			// as this Curveball is going left, its curve is mirrored
+			// this allows for a quick and easy change from throwing it right
+			if (curveball != NULL)
+			{
+				curveball->Throw(true);
+			}
 		}
 	}
 
@@ -465,139 +553,89 @@ void ACourseworkCodeCharacter::StopRotatingSageWall()
 	isRotatingWall = false;
 }
 
-// controls the spawning of the Fury Shot projectile
+// fires a single Fury Shot projectile from the muzzle straight away
 void ACourseworkCodeCharacter::OnFire()
 {
-
-	// only shoot if player is holding down or pressing the shoot button
-
-	if (isShooting)
+	UWorld* const World = GetWorld();
+	if (World == NULL)
 	{
+		return;
+	}
 
-		// made false to allow for a controlled loop
-		// of automatic fire and changing fire rate
-		isShooting = false;
-
-		// checks if the Fury Shot ability is active
-
-		// if it is not, spawn projectiles at normal fire rate when auto
-		if (!isFuryActivated)
-		{
-			// try and fire a projectile
-			if (FuryShotClass != NULL)
-			{
-				// if able to spawn, get world
-				UWorld* const World = GetWorld();
-				if (World != NULL)
-				{
-
-
-					const FRotator SpawnRotation = GetControlRotation();
-					// MuzzleOffset is in camera space, so transform it to world space before offsetting from the character location to find the final muzzle position
-					const FVector SpawnLocation = ((FP_MuzzleLocation != nullptr) ? FP_MuzzleLocation->GetComponentLocation() : GetActorLocation()) + SpawnRotation.RotateVector(GunOffset);
-
-					//Set Spawn Collision Handling Override
-					FActorSpawnParameters ActorSpawnParams;
-					ActorSpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButDontSpawnIfColliding;
-
-					// spawn the Fury Shot projectile at the muzzle
-					World->SpawnActor<AFuryShot>(FuryShotClass, SpawnLocation, SpawnRotation, ActorSpawnParams);
-
-				}
-			}
-
-			else
-			{
-				// if the projectile doesnt spawn, output a debug message to screen telling the player
-				GEngine->AddOnScreenDebugMessage(-1, 2.0f, FColor::Cyan, FString("Function has not been called correctly"));
-			}
-
-			// try and play the sound if specified
-			if (FireSound != NULL)
-			{
-				UGameplayStatics::PlaySoundAtLocation(this, FireSound, GetActorLocation(), 0.1f);
-			}
-
-			// try and play a firing animation if specified
-			if (FireAnimation != NULL)
-			{
-				// Get the animation object for the arms mesh
-				UAnimInstance* AnimInstance = Mesh1P->GetAnimInstance();
-				if (AnimInstance != NULL)
-				{
-					AnimInstance->Montage_Play(FireAnimation, 1.f);
-				}
-			}
+	FireShot(World->GetTimeSeconds());
+}
 
-			// sets the fire rate of the auto fire based on a timer using the standard auto fire rate
-			GetWorld()->GetTimerManager().SetTimer(FireHandle, this, &ACourseworkCodeCharacter::setFiring, autoFireRate, false);
+// fires a single Fury Shot projectile from the muzzle
+// the projectile, sound and animation are handed to the fire pipeline
+// which resolves the shots of every player together at the end of the frame
+void ACourseworkCodeCharacter::FireShot(double FireTime)
+{
+	UWorld* const World = GetWorld();
+	if (World == NULL)
+	{
+		return;
+	}
 
-		}
+	FFireRequest fireRequest;
+	fireRequest.shooter = this;
+	fireRequest.fireTime = FireTime;
+	fireRequest.spawnProjectile = FuryShotClass != NULL;
 
+	fireRequest.spawnRotation = GetControlRotation();
+	// MuzzleOffset is in camera space, so transform it to world space before offsetting from the character location to find the final muzzle position
+	fireRequest.spawnLocation = ((FP_MuzzleLocation != nullptr) ? FP_MuzzleLocation->GetComponentLocation() : GetActorLocation()) + fireRequest.spawnRotation.RotateVector(GunOffset);
 
-		// if Fury Shot ability is active, spawn projectiles at increased fire rate when auto
-		else
-		{
-			// try and fire a projectile
-			if (FuryShotClass != NULL)
-			{
-				// if able to spawn, get world
-				UWorld* const World = GetWorld();
-				if (World != NULL)
-				{
+	if (FuryShotClass == NULL)
+	{
+		// if the projectile doesnt spawn, output a debug message to screen telling the player
+		GEngine->AddOnScreenDebugMessage(-1, 2.0f, FColor::Cyan, FString("Function has not been called correctly"));
+	}
 
-					const FRotator SpawnRotation = GetControlRotation();
-					// MuzzleOffset is in camera space, so transform it to world space before offsetting from the character location to find the final muzzle position
-					const FVector SpawnLocation = ((FP_MuzzleLocation != nullptr) ? FP_MuzzleLocation->GetComponentLocation() : GetActorLocation()) + SpawnRotation.RotateVector(GunOffset);
+	World->GetSubsystem<UFirePipeline>()->SubmitFireRequest(fireRequest);
+}
 
-					//Set Spawn Collision Handling Override
-					FActorSpawnParameters ActorSpawnParams;
-					ActorSpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButDontSpawnIfColliding;
+// fires a single Fury Shot from the given location and rotation
+// uses the fury shot simulation if enabled, otherwise takes a projectile actor from the pool
+void ACourseworkCodeCharacter::SpawnFuryShot(const FVector& SpawnLocation, const FRotator& SpawnRotation, double FireTime)
+{
+	UWorld* const World = GetWorld();
 
-					// spawn the Fury Shot projectile at the muzzle
-					World->SpawnActor<AFuryShot>(FuryShotClass, SpawnLocation, SpawnRotation, ActorSpawnParams);
+	UFuryShotSimulation* furyShotSimulation = World->GetSubsystem<UFuryShotSimulation>();
+	if (useFuryShotSimulation && furyShotSimulation != NULL)
+	{
+		// damage is decided once when the shot is fired
+		const int shotDamage = FuryShotClass->GetDefaultObject<AFuryShot>()->getDamageForFury(isFuryActivated);
 
-				}
-			}
+		furyShotSimulation->SpawnShot(FuryShotClass, SpawnLocation, SpawnRotation, shotDamage, this, FireTime);
+		return;
+	}
 
-			else
-			{
-				// if the projectile doesnt spawn, output a debug message to screen telling the player
-				GEngine->AddOnScreenDebugMessage(-1, 2.0f, FColor::Cyan, FString("Function has not been called correctly"));
-			}
+	//Set Spawn Collision Handling Override
+	FActorSpawnParameters ActorSpawnParams;
+	ActorSpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButDontSpawnIfColliding;
 
-			// try and play the sound if specified
-			if (FireSound != NULL)
-			{
-				UGameplayStatics::PlaySoundAtLocation(this, FireSound, GetActorLocation(), 0.1f);
-			}
+	// take a Fury Shot projectile from the pool and fire it from the muzzle
+	UAbilityActorPool* pool = World->GetSubsystem<UAbilityActorPool>();
+	AFuryShot* furyShot = pool->Acquire<AFuryShot>(FuryShotClass, FTransform(SpawnRotation, SpawnLocation), ActorSpawnParams);
 
-			// try and play a firing animation if specified
-			if (FireAnimation != NULL)
-			{
-				// Get the animation object for the arms mesh
-				UAnimInstance* AnimInstance = Mesh1P->GetAnimInstance();
-				if (AnimInstance != NULL)
-				{
-					AnimInstance->Montage_Play(FireAnimation, 1.f);
-				}
-			}
-
-			// sets the fire rate of the auto fire based on a timer using the fury shot increased fire rate
-			GetWorld()->GetTimerManager().SetTimer(FireHandle, this, &ACourseworkCodeCharacter::setFiring, furyFireRate, false);
-		}
+	// set the damage and flame effect once from the current Fury Shot state
+	if (furyShot != NULL)
+	{
+		furyShot->InitFromShooter(this);
 
-		
+		// move the shot on by the time since it was fired
+		furyShot->AdvanceSpawnTime(float(World->GetTimeSeconds() - FireTime));
 	}
-
-	
 }
 
 // when input from player received, activate the Fury Fire ability
 // increase the fire of the weapon for a limited amount of time
 void ACourseworkCodeCharacter::ActivateFuryFire()
 {
-	isFuryActivated = true;
+	setIsFuryActivated(true);
+
+	// switch the automatic fire over to the faster fire rate
+	fireScheduler.SetFireInterval(furyFireRate, GetWorld()->GetTimeSeconds());
 
 	// carries out the deactivate function once the ability has been active for its set amount of time
 	GetWorld()->GetTimerManager().SetTimer(FuryFireTimerHandle, this, &ACourseworkCodeCharacter::DeactivateFuryFire, furyFireAbilityLength,false);
@@ -609,7 +647,10 @@ void ACourseworkCodeCharacter::ActivateFuryFire()
 void ACourseworkCodeCharacter::DeactivateFuryFire()
 {
 
-	isFuryActivated = false;
+	setIsFuryActivated(false);
+
+	// switch the automatic fire back to the standard fire rate
+	fireScheduler.SetFireInterval(autoFireRate, GetWorld()->GetTimeSeconds());
 
 	// clears the time handle from the Fury Fire ability
 	// allows it to be reused again 
@@ -621,34 +662,47 @@ void ACourseworkCodeCharacter::DeactivateFuryFire()
 
 
 // allows for the weapon to shoot in full auto
-// by looping the firing function using a timer
+// the fire scheduler decides when each shot is due based on the current fire rate
 
 void ACourseworkCodeCharacter::OnFireAuto()
 {
-	// set to allow for shooting
-	isShooting = true;
-	
-	// loops the OnFire() function with a very low value to act as a constant fire rate
-	GetWorld()->GetTimerManager().SetTimer(AutoFireTimerHandle, this, &ACourseworkCodeCharacter::OnFire, 0.001f, true);
+	// start the burst from the moment the button was pressed if it was recorded
+	double pressTime = GetWorld()->GetTimeSeconds();
+	if (fireInputTimestamps.IsValid())
+	{
+		fireInputTimestamps->ConsumePressTime(GetWorld(), pressTime);
+	}
 
+	fireScheduler.StartFiring(pressTime);
+
+	// fire the first shot straight away rather than waiting for the next tick
+	FireDueShots();
 }
 
-// clears the timer handles used inside the OnFire() function
-// allows for the next bullet to be shot
-void ACourseworkCodeCharacter::setFiring()
+// stops the weapon from firing once the player stops pressing the button to fire
+void ACourseworkCodeCharacter::StopFiring()
 {
-	isShooting = true;
+	double releaseTime = GetWorld()->GetTimeSeconds();
+	if (fireInputTimestamps.IsValid())
+	{
+		fireInputTimestamps->ConsumeReleaseTime(GetWorld(), releaseTime);
+	}
 
-	GetWorldTimerManager().ClearTimer(FireHandle);
+	fireScheduler.StopFiring(releaseTime);
 }
 
-// stops the weapon from firing once the player stops pressing the button to fire
-// clears the timer handle used inside the OnFireAuto() function 
-void ACourseworkCodeCharacter::StopFiring()
+// fires one shot for every shot the scheduler has due up to the current time
+// at low frame rates this can be more than one shot per frame
+void ACourseworkCodeCharacter::FireDueShots()
 {
-	isShooting = false;
+	dueShotTimes.Reset();
+	fireScheduler.Advance(GetWorld()->GetTimeSeconds(), dueShotTimes);
 
-	GetWorldTimerManager().ClearTimer(AutoFireTimerHandle);
+	// each shot keeps the time it was due, so shots fired in the same frame leave the muzzle spaced apart
+	for (int32 i = 0; i < dueShotTimes.Num(); i++)
+	{
+		FireShot(dueShotTimes[i]);
+	}
 }
 
 void ACourseworkCodeCharacter::OnResetVR()
@@ -662,9 +716,10 @@ void ACourseworkCodeCharacter::BeginTouch(const ETouchIndex::Type FingerIndex, c
 	{
 		return;
 	}
+	// touch fires through the scheduler the same way the fire button does, so tapping can't beat the fire rate
 	if ((FingerIndex == TouchItem.FingerIndex) && (TouchItem.bMoved == false))
 	{
-		OnFire();
+		OnFireAuto();
 	}
 	TouchItem.bIsPressed = true;
 	TouchItem.FingerIndex = FingerIndex;
@@ -678,6 +733,10 @@ void ACourseworkCodeCharacter::EndTouch(const ETouchIndex::Type FingerIndex, con
 	{
 		return;
 	}
+	if (FingerIndex == TouchItem.FingerIndex)
+	{
+		StopFiring();
+	}
 	TouchItem.bIsPressed = false;
 }
 
@@ -737,6 +796,15 @@ void ACourseworkCodeCharacter::MoveRight(float Value)
 	}
 }
 
+// the mouse turns the sage wall instead of the camera while the wall is being rotated
+void ACourseworkCodeCharacter::Turn(float Val)
+{
+	if (!isRotatingWall)
+	{
+		AddControllerYawInput(Val);
+	}
+}
+
 void ACourseworkCodeCharacter::TurnAtRate(float Rate)
 {
 	// calculate delta for this frame from the rate information
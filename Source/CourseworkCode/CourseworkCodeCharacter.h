@@ -4,10 +4,15 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/Character.h"
+#include "FireScheduler.h"
 #include "CourseworkCodeCharacter.generated.h"
 
 //class ACurveball;
 class UInputComponent;
+class FFireInputTimestamps;
+
+// broadcast whenever the Fury Shot ability is switched on or off
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnFuryStateChanged, bool, isFuryActivated);
 
 UCLASS(config=Game)
 class ACourseworkCodeCharacter : public ACharacter
@@ -54,6 +59,10 @@ class ACourseworkCodeCharacter : public ACharacter
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, meta = (AllowPrivateAccess = "true"))
 	class UMotionControllerComponent* L_MotionController;
 
+	/** Fades out Curveball flashes and writes them to the flash post process */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, meta = (AllowPrivateAccess = "true"))
+	class UFlashEffectComponent* FlashEffect;
+
 public:
 	ACourseworkCodeCharacter();
 
@@ -89,15 +98,29 @@ public:
 	UFUNCTION()
 		void setIsFuryActivated(bool val);
 
+	// Check the flash amount worked out by the last flashbang range check
+
+	float getFlashAmount() const { return flashAmount; }
+
+	/** called when the Fury Shot ability starts or ends */
+	UPROPERTY(BlueprintAssignable)
+	FOnFuryStateChanged OnFuryStateChanged;
+
 	/*UFUNCTION()
 		float getFireRate();
 
 	UFUNCTION()
 		void setFireRate(float val);*/
 
+	// fires any automatic fire shots that became due this frame
+	virtual void Tick(float DeltaSeconds) override;
+
 protected:
 	virtual void BeginPlay();
 
+	// stops recording fire input times
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
 	// Variables used within the classes and blueprints if necessary
 
 
@@ -117,6 +140,10 @@ protected:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite)
 	float furyFireAbilityLength;
 
+	/** coarsest input clock in seconds that fire input is back-dated with, a coarser clock fires at the frame time instead */
+	UPROPERTY(config, EditAnywhere, BlueprintReadOnly)
+	float maxFireInputTimestampResolution;
+
 	// bool to check if player is placing Sage Wall
 	UPROPERTY(EditAnywhere, BlueprintReadWrite)
 	bool isPlacingWall;
@@ -129,15 +156,23 @@ protected:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite)
 	bool isFuryActivated;
 
-	// bool to check if player is shooting
+	// bool to simulate fired Fury Shots in the packed fury shot simulation
+	// instead of spawning a projectile actor for every bullet
 	UPROPERTY(EditAnywhere, BlueprintReadWrite)
-	bool isShooting;
+	bool useFuryShotSimulation;
 
 	
-	// Timer handles to control rate of fire and fury shot ability length
-	FTimerHandle AutoFireTimerHandle;
+	// Timer handle to control the fury shot ability length
 	FTimerHandle FuryFireTimerHandle;
-	FTimerHandle FireHandle;
+
+	// works out when automatic fire shots are due based on the current fire rate
+	FFireScheduler fireScheduler;
+
+	// times of the shots due this frame, kept between frames to avoid reallocating
+	TArray<double> dueShotTimes;
+
+	// records the exact time the fire button is pressed and released within the frame
+	TSharedPtr<FFireInputTimestamps> fireInputTimestamps;
 
 
 public:
@@ -177,11 +212,16 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Gameplay)
 	class UAnimMontage* FireAnimation;
 
+	/** Spawns a single Fury Shot, either as a pooled actor or inside the fury shot simulation
+	the shot is moved forward to where it would be if it had left the muzzle at the fire time */
+	void SpawnFuryShot(const FVector& SpawnLocation, const FRotator& SpawnRotation, double FireTime);
+
 	/** Whether to use motion controller location for aiming. */
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Gameplay)
 	uint32 bUsingMotionControllers : 1;
 
-	/** Event called within the character blueprint to control flashbang */
+	/** Event called within the character blueprint to control flashbang
+	no longer called from C++, flashes now go through the flash effect component */
 	UFUNCTION(BlueprintImplementableEvent)
 		void ifInFlashbangRangeEvent(const float& distance, const FVector& facingAngle);
 
@@ -216,6 +256,9 @@ protected:
 	/** Fires a projectile. */
 	void OnFire();
 
+	/** Fires a projectile at the given world time within this frame */
+	void FireShot(double FireTime);
+
 	/** Activates Fury Fire ability */
 	void ActivateFuryFire();
 
@@ -225,12 +268,12 @@ protected:
 	/** Begins firing the gun in full auto */
 	void OnFireAuto();
 
-	/** Sets player to firing */
-	void setFiring();
-
 	/** Sets player to stop firing */
 	void StopFiring();
 
+	/** Fires every shot the fire scheduler has due up to the current time */
+	void FireDueShots();
+
 	/** Resets HMD orientation and position in VR. */
 	void OnResetVR();
 
@@ -240,6 +283,9 @@ protected:
 	/** Handles stafing movement, left and right */
 	void MoveRight(float Val);
 
+	/** Handles turning with the mouse, ignored while a Sage Wall is being rotated */
+	void Turn(float Val);
+
 	/**
 	 * Called via input to turn at a given rate.
 	 * @param Rate	This is a normalized rate, i.e. 1.0 means 100% of desired turn rate
@@ -283,6 +329,8 @@ public:
 	FORCEINLINE class USkeletalMeshComponent* GetMesh1P() const { return Mesh1P; }
 	/** Returns FirstPersonCameraComponent subobject **/
 	FORCEINLINE class UCameraComponent* GetFirstPersonCameraComponent() const { return FirstPersonCameraComponent; }
+	/** Returns FlashEffect subobject **/
+	FORCEINLINE class UFlashEffectComponent* GetFlashEffect() const { return FlashEffect; }
 
 };
 
@@ -3,6 +3,8 @@
 #include "CourseworkCodeGameMode.h"
 #include "CourseworkCodeHUD.h"
 #include "CourseworkCodeCharacter.h"
+#include "FlashOcclusionGrid.h"
+#include "Engine/World.h"
 #include "UObject/ConstructorHelpers.h"
 
 ACourseworkCodeGameMode::ACourseworkCodeGameMode()
@@ -15,3 +17,15 @@ ACourseworkCodeGameMode::ACourseworkCodeGameMode()
 	// use our custom HUD class
 	HUDClass = ACourseworkCodeHUD::StaticClass();
 }
+
+void ACourseworkCodeGameMode::StartPlay()
+{
+	// loading, or baking a map that has no grid yet, happens while the map is loading instead of on the first flash
+	UFlashOcclusionGrid* occlusionGrid = GetWorld()->GetSubsystem<UFlashOcclusionGrid>();
+	if (occlusionGrid != NULL)
+	{
+		occlusionGrid->PrepareGrid();
+	}
+
+	Super::StartPlay();
+}
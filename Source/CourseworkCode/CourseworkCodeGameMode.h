@@ -13,6 +13,9 @@ class ACourseworkCodeGameMode : public AGameModeBase
 
 public:
 	ACourseworkCodeGameMode();
+
+	// gets the flash occlusion grid ready before anyone can throw a flash
+	virtual void StartPlay() override;
 };
 
 
@@ -1,6 +1,7 @@
 // Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
 
 #include "CourseworkCodeProjectile.h"
+#include "DamageResolutionQueue.h"
 #include "GameFramework/ProjectileMovementComponent.h"
 #include "Components/SphereComponent.h"
 
@@ -37,7 +38,8 @@ void ACourseworkCodeProjectile::OnHit(UPrimitiveComponent* HitComp, AActor* Othe
 	// Only add impulse and destroy projectile if we hit a physics
 	if ((OtherActor != NULL) && (OtherActor != this) && (OtherComp != NULL) && OtherComp->IsSimulatingPhysics())
 	{
-		OtherComp->AddImpulseAtLocation(GetVelocity() * 100.0f, GetActorLocation());
+		// the impulse is added with every other hit on the component at the end of the frame
+		UDamageResolutionQueue::QueueImpulse(OtherComp, GetVelocity() * 100.0f, GetActorLocation());
 
 		Destroy();
 	}
@@ -0,0 +1,72 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+
+/**
+ * Game world the automation tests spawn their actors into, destroyed again when it goes out of scope
+ * play is only started if asked for, otherwise actors only do what the test calls on them
+ */
+class FCourseworkCodeTestWorld
+{
+public:
+
+	explicit FCourseworkCodeTestWorld(bool startPlay = false)
+	{
+		World = UWorld::CreateWorld(EWorldType::Game, false);
+		FWorldContext& worldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+		worldContext.SetCurrentWorld(World);
+
+		// play is started through the game mode, which calls BeginPlay on every actor and registers their ticks
+		if (startPlay)
+		{
+			World->SetGameMode(FURL());
+		}
+
+		World->InitializeActorsForPlay(FURL());
+
+		if (startPlay)
+		{
+			World->BeginPlay();
+		}
+	}
+
+	~FCourseworkCodeTestWorld()
+	{
+		GEngine->DestroyWorldContext(World);
+		World->DestroyWorld(false);
+	}
+
+	FCourseworkCodeTestWorld(const FCourseworkCodeTestWorld&) = delete;
+	FCourseworkCodeTestWorld& operator=(const FCourseworkCodeTestWorld&) = delete;
+
+	UWorld* GetWorld() const { return World; }
+
+	// spawns the actor even if it overlaps something already in the world
+	template<typename T>
+	T* SpawnActor(const FTransform& transform, UClass* actorClass = T::StaticClass()) const
+	{
+		FActorSpawnParameters spawnParams;
+		spawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+		return World->SpawnActor<T>(actorClass, transform, spawnParams);
+	}
+
+	// ticks every actor and component, async traces submitted during the tick are run at the end of it
+	void Tick(float DeltaTime) const
+	{
+		World->Tick(LEVELTICK_All, DeltaTime);
+	}
+
+private:
+
+	UWorld* World;
+};
+
+#endif
@@ -4,12 +4,15 @@
 #include "Curveball.h"
 //#include "K2Node_DynamicCast.h"
 #include "CourseworkCodeCharacter.h"
+#include "CurveballFlightManager.h"
+#include "FlashbangResolver.h"
 #include "Engine/StaticMesh.h"
 #include "Runtime/CoreUObject/Public/UObject/ConstructorHelpers.h"
 #include "Camera/CameraComponent.h"
 #include "Engine/Engine.h"
 #include "Engine/World.h"
 #include "DrawDebugHelpers.h"
+#include "Components/TimelineComponent.h"
 #include "Runtime/Engine/Classes/Kismet/GameplayStatics.h"
 
 
@@ -18,8 +21,8 @@
 // Sets default values
 ACurveball::ACurveball()
 {
- 	// Set this actor to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
-	PrimaryActorTick.bCanEverTick = true;
+ 	// curveballs never tick, they are moved by the flight manager or the blueprint timeline
+	PrimaryActorTick.bCanEverTick = false;
 
 	// setting scene component as root component
 	curveballSceneComp = CreateDefaultSubobject<USceneComponent>(TEXT("Curveball Scene"));
@@ -48,6 +51,10 @@ ACurveball::ACurveball()
 	// sets initial value of the offset the curveball will use
 	curveballEndOffset = FVector(300.0f, 300.0f, 0.0f);
 
+	// the flight manager moves the curveball by default, this can be overridden in DefaultGame.ini
+	useFlightManager = true;
+	flightDuration = 1.0f;
+
 	
 	
 }
@@ -67,6 +74,7 @@ void ACurveball::UpdateSpline(const FVector& CurveStart, const FVector& CurveEnd
 	curvePoint = (CurveStart + CurveEnd / 2.0f) + FVector(100.0f,-150.0f,0.0f);
 	
 	// adds each point of the spline to an array
+	splineArray.Reserve(3);
 	splineArray.Add(CurveStart);
 	splineArray.Add(curvePoint);
 	splineArray.Add(CurveEnd);
@@ -88,84 +96,148 @@ void ACurveball::SplineLocationProgress(float timeVal, USplineComponent* splineC
 }
 
 
-// checks if the curveball can see the player camera using a line trace
-// if there is block between the trace, the player will not be flashed
-
-void ACurveball::curveballFlash()
+// the flight manager flies the curveball along the same path the spline would have
+// left throws mirror the curve instead of spawning the curveball with a negative scale
+void ACurveball::Throw(bool mirrored)
 {
+	if (!useFlightManager)
+	{
+		// the spline path and timeline were already started when the curveball was spawned or taken from the pool
+		SetActorScale3D(FVector(1.0f, mirrored ? -1.0f : 1.0f, 1.0f));
+		return;
+	}
 
-	// casts to the player character in order to access the character variables and functions
+	UWorld* const World = GetWorld();
+	UCurveballFlightManager* flightManager = World != NULL ? World->GetSubsystem<UCurveballFlightManager>() : NULL;
 
-	class ACourseworkCodeCharacter* playerPawn = Cast<ACourseworkCodeCharacter>(UGameplayStatics::GetPlayerPawn(GetWorld(), 0));
+	FVector curveStart, curvePoint, curveEnd;
+	// the flight manager places the curveball at the start of the curve once it is mirrored
+	if (flightManager != NULL && GetCurvePoints(curveStart, curvePoint, curveEnd))
+	{
+		flightManager->StartFlight(this, curveStart, curvePoint, curveEnd, flightDuration, mirrored);
+	}
+}
 
-	// set variables to be used within the line trace
-	FVector startPoint = curveballStaticMesh->GetComponentLocation();
-	FVector endPoint = playerPawn->GetFirstPersonCameraComponent()->GetComponentLocation();
-	FHitResult hit;
-	float distanceRange;
+void ACurveball::SetFlightLocation(const FVector& flightLocation)
+{
+	curveballStaticMesh->SetRelativeLocation(flightLocation, false);
+}
 
-	FCollisionQueryParams traceParams;
-	
-	// ignore itself for collisions
+// finds every listener in range that can see the curveball and flashes them
+// the line of sight traces run in the async trace batch, so the curveball can go back to the pool straight away
+
+void ACurveball::curveballFlash()
+{
+	UWorld* const World = GetWorld();
+	UFlashbangResolver* flashbangResolver = World != NULL ? World->GetSubsystem<UFlashbangResolver>() : NULL;
 
-	traceParams.AddIgnoredActor(this);
+	if (flashbangResolver != NULL)
+	{
+		flashbangResolver->Detonate(curveballStaticMesh->GetComponentLocation(), this);
+	}
 
-	// begin the line trace 
-	bool bHit = GetWorld()->LineTraceSingleByChannel(hit, startPoint, endPoint, ECC_Visibility, traceParams);
+	// destroy the curveball once the flash has went off
+	UAbilityActorPool::ReleaseOrDestroy(this);
+}
 
-	// draw debug lines to help with making sure the line is drawing correctly
 
-	DrawDebugLine(GetWorld(), startPoint, endPoint, FColor::Red, false, 3.0f);
+// restarts the curveball as if it had just been thrown
+void ACurveball::OnAcquiredFromPool()
+{
+	// move the mesh back to the start of the path
+	curveballStaticMesh->SetRelativeLocation(FVector::ZeroVector);
 
-	// if there was a hit with the line trace
-	// destroy the curveball and dont flash
-	if (bHit)
+	// the flight manager starts the flight once the curveball is thrown
+	if (useFlightManager)
 	{
-		Destroy();
+		return;
 	}
 
-	// if there was no hit
-	else
-	{
-		// determine distance from flash
-		// determine angle from flash
-		// destroy the curveball once the flash has went off
+	InitCurveFromPlayer();
+
+	// the blueprint timelines only auto play on begin play
+	// so restart them here to throw the curveball again
+	TInlineComponentArray<UTimelineComponent*> timelines;
+	GetComponents(timelines);
 
-		distanceRange =	GetDistanceTo(playerPawn);
-		playerPawn->ifInFlashbangRangeEvent(distanceRange, startPoint);
-		Destroy();
+	for (UTimelineComponent* timeline : timelines)
+	{
+		timeline->PlayFromStart();
 	}
+}
+
+// stops the flight so the pooled curveball doesn't flash
+void ACurveball::OnReleasedToPool()
+{
+	StopTimelines();
 
+	UWorld* const World = GetWorld();
+	UCurveballFlightManager* flightManager = World != NULL ? World->GetSubsystem<UCurveballFlightManager>() : NULL;
+
+	if (flightManager != NULL)
+	{
+		flightManager->StopFlight(this);
+	}
 }
 
+void ACurveball::StopTimelines()
+{
+	TInlineComponentArray<UTimelineComponent*> timelines;
+	GetComponents(timelines);
 
-// Called when the game starts or when spawned
-void ACurveball::BeginPlay()
+	for (UTimelineComponent* timeline : timelines)
+	{
+		timeline->Stop();
+	}
+}
+
+// sets the start and end points of the curve based on where the player is looking
+void ACurveball::InitCurveFromPlayer()
 {
-	Super::BeginPlay();
+	FVector curveballStart, curveballPoint, curveballEnd;
 
-	FVector curveballStart, curveballEnd;
+	// calls the function that will create the spline path
+	if (GetCurvePoints(curveballStart, curveballPoint, curveballEnd))
+	{
+		UpdateSpline(curveballStart, curveballEnd);
+	}
+}
 
+bool ACurveball::GetCurvePoints(FVector& outCurveStart, FVector& outCurvePoint, FVector& outCurveEnd) const
+{
 	// casts to the player character in order to access the character variables and functions
 	class ACourseworkCodeCharacter* playerPawn = Cast<ACourseworkCodeCharacter>(UGameplayStatics::GetPlayerPawn(GetWorld(), 0));
-	
-	// set start and end points of the curveball ability to be passed in to the spline
-	curveballStart = playerPawn->GetFirstPersonCameraComponent()->GetForwardVector();
 
-	curveballEnd = playerPawn->GetFirstPersonCameraComponent()->GetForwardVector() + curveballEndOffset;
+	// the player may not exist yet if the curveball was spawned into the pool ahead of time
+	if (playerPawn == NULL)
+	{
+		return false;
+	}
 
-	// calls the function that will create the spline path
-	UpdateSpline(curveballStart, curveballEnd);
-	
-}
+	// set start and end points of the curveball ability
+	outCurveStart = playerPawn->GetFirstPersonCameraComponent()->GetForwardVector();
 
-// Called every frame
-void ACurveball::Tick(float DeltaTime)
-{
-	Super::Tick(DeltaTime);
+	outCurveEnd = playerPawn->GetFirstPersonCameraComponent()->GetForwardVector() + curveballEndOffset;
 
+	// same curving point as the spline path
+	outCurvePoint = (outCurveStart + outCurveEnd / 2.0f) + FVector(100.0f, -150.0f, 0.0f);
 
+	return true;
 }
 
+// Called when the game starts or when spawned
+void ACurveball::BeginPlay()
+{
+	Super::BeginPlay();
 
+	// the flight manager moves the curveball instead of the blueprint timelines, which auto play on begin play
+	if (useFlightManager)
+	{
+		StopTimelines();
+	}
 
+	else
+	{
+		InitCurveFromPlayer();
+	}
+}
@@ -8,12 +8,13 @@
 #include "Components/SplineComponent.h"
 #include "Components/SceneComponent.h"
 #include "GameFramework/Actor.h"
+#include "AbilityActorPool.h"
 #include "Curveball.generated.h"
 
 //class ACourseworkCodeCharacter;
 
 UCLASS(config=game)
-class COURSEWORKCODE_API ACurveball : public AActor
+class COURSEWORKCODE_API ACurveball : public AActor, public IPooledAbilityActor
 {
 	GENERATED_BODY()
 
@@ -36,6 +37,14 @@ protected:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite)
 		FVector	curveballEndOffset;
 
+	/** if true the flight manager flies the curveball along a closed form curve, otherwise the blueprint timeline moves it along the spline */
+	UPROPERTY(config, EditAnywhere, BlueprintReadOnly)
+		bool useFlightManager;
+
+	/** time in seconds the curveball takes to fly along the whole curve before flashing */
+	UPROPERTY(config, EditAnywhere, BlueprintReadOnly)
+		float flightDuration;
+
 
 public:	
 	// Sets default values for this actor's properties
@@ -51,18 +60,36 @@ public:
 	UFUNCTION(BlueprintCallable)
 		void SplineLocationProgress(float timeVal, USplineComponent* splineComp, UStaticMeshComponent* staticMeshComp);
 
-	// determines if the curveball can see the player camera
-	// and whether it will flash the player or not
+	// throws the curveball along its curve, mirrored throws curve to the left instead of the right
+	void Throw(bool mirrored);
+
+	// moves the curveball to a point on its curve, given in its local space
+	void SetFlightLocation(const FVector& flightLocation);
+
+	// flashes every listener in range that can see the curveball
 	UFUNCTION(BlueprintCallable)
 		void curveballFlash();
 
+	// pool reset hooks
+	// rebuilds the curve from the player and restarts the flight when thrown again
+	virtual void OnAcquiredFromPool() override;
+
+	// stops the flight while the curveball waits in the pool
+	virtual void OnReleasedToPool() override;
+
 protected:
-	// Called when the game starts or when spawned
-	virtual void BeginPlay() override;
 
-public:	
+	// sets up the curve path using the current view of the player
+	void InitCurveFromPlayer();
+
+	// works out the start, curving and end points of the path from the current view of the player
+	// returns false if there is no player to throw from
+	bool GetCurvePoints(FVector& outCurveStart, FVector& outCurvePoint, FVector& outCurveEnd) const;
 
-	// Called every frame
-	virtual void Tick(float DeltaTime) override;
+	// stops the blueprint timelines that move the curveball along the spline
+	void StopTimelines();
+
+	// Called when the game starts or when spawned
+	virtual void BeginPlay() override;
 
 };
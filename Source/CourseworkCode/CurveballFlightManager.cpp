@@ -0,0 +1,165 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "CurveballFlightManager.h"
+#include "CourseworkCode.h"
+#include "Curveball.h"
+#include "Engine/World.h"
+
+DECLARE_CYCLE_STAT(TEXT("Curveball Flight Tick"), STAT_CurveballFlightTick, STATGROUP_CourseworkCode);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Curveballs In Flight"), STAT_CurveballsInFlight, STATGROUP_CourseworkCode);
+
+void UCurveballFlightManager::Deinitialize()
+{
+	DEC_DWORD_STAT_BY(STAT_CurveballsInFlight, flights.Num());
+
+	flights.Empty();
+	finishedCurveballs.Empty();
+
+	Super::Deinitialize();
+}
+
+// a curveball that is thrown again while still flying starts its new curve from the beginning
+void UCurveballFlightManager::StartFlight(ACurveball* curveball, const FVector& curveStart, const FVector& curvePoint, const FVector& curveEnd, float flightDuration, bool mirrored)
+{
+	if (curveball == NULL)
+	{
+		return;
+	}
+
+	StopFlight(curveball);
+
+	// mirroring the points flips the curve to the other side, like throwing with the Y-Axis scaled by -1
+	const FVector mirror = mirrored ? FVector(1.0f, -1.0f, 1.0f) : FVector(1.0f, 1.0f, 1.0f);
+
+	FCurveballFlight flight;
+	flight.curveball = curveball;
+	flight.start = curveStart * mirror;
+	flight.end = curveEnd * mirror;
+
+	// pick the control point so the curve passes through the curve point halfway along
+	flight.control = 2.0f * (curvePoint * mirror) - 0.5f * (flight.start + flight.end);
+
+	MeasureCurve(flight);
+
+	flight.distance = 0.0f;
+	flight.speed = flightDuration > 0.0f ? flight.arcLengths[FCurveballFlight::numArcLengthSamples] / flightDuration : BIG_NUMBER;
+
+	// place the curveball at the start of the mirrored curve now, so it isn't drawn on the wrong side until the next update
+	curveball->SetFlightLocation(flight.start);
+
+	flights.Add(flight);
+	INC_DWORD_STAT(STAT_CurveballsInFlight);
+}
+
+void UCurveballFlightManager::StopFlight(ACurveball* curveball)
+{
+	const int32 flightIndex = flights.IndexOfByPredicate([curveball](const FCurveballFlight& flight)
+	{
+		return flight.curveball.Get() == curveball;
+	});
+
+	if (flightIndex != INDEX_NONE)
+	{
+		flights.RemoveAtSwap(flightIndex, 1, false);
+		DEC_DWORD_STAT(STAT_CurveballsInFlight);
+	}
+}
+
+FVector UCurveballFlightManager::GetLocationAtParameter(const FCurveballFlight& flight, float t)
+{
+	const float oneMinusT = 1.0f - t;
+
+	return oneMinusT * oneMinusT * flight.start + 2.0f * oneMinusT * t * flight.control + t * t * flight.end;
+}
+
+// straight lines between evenly spaced points on the curve, close enough for the short curve a curveball flies
+void UCurveballFlightManager::MeasureCurve(FCurveballFlight& flight)
+{
+	flight.arcLengths[0] = 0.0f;
+
+	FVector previousLocation = flight.start;
+	for (int32 i = 1; i <= FCurveballFlight::numArcLengthSamples; i++)
+	{
+		const FVector location = GetLocationAtParameter(flight, (float)i / FCurveballFlight::numArcLengthSamples);
+
+		flight.arcLengths[i] = flight.arcLengths[i - 1] + FVector::Dist(previousLocation, location);
+		previousLocation = location;
+	}
+}
+
+// finds the sample the distance falls in and blends the curve parameter between its ends
+// so equal steps in distance move the curveball equal distances along the curve
+FVector UCurveballFlightManager::GetLocationAtDistance(const FCurveballFlight& flight, float distance)
+{
+	const float totalLength = flight.arcLengths[FCurveballFlight::numArcLengthSamples];
+	if (totalLength <= 0.0f || distance >= totalLength)
+	{
+		return flight.end;
+	}
+
+	int32 sample = 1;
+	while (sample < FCurveballFlight::numArcLengthSamples && flight.arcLengths[sample] < distance)
+	{
+		sample++;
+	}
+
+	const float sampleStart = flight.arcLengths[sample - 1];
+	const float sampleLength = flight.arcLengths[sample] - sampleStart;
+	const float sampleAlpha = sampleLength > 0.0f ? (distance - sampleStart) / sampleLength : 0.0f;
+
+	return GetLocationAtParameter(flight, (sample - 1 + sampleAlpha) / FCurveballFlight::numArcLengthSamples);
+}
+
+bool UCurveballFlightManager::IsTickable() const
+{
+	UWorld* const World = GetWorld();
+
+	return World != NULL && World->IsGameWorld() && flights.Num() > 0;
+}
+
+TStatId UCurveballFlightManager::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UCurveballFlightManager, STATGROUP_Tickables);
+}
+
+// moves every curveball along its curve, then flashes the ones that reached the end
+// flashing can hand the curveball back to the pool, so it happens after the flights have been updated
+void UCurveballFlightManager::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_CurveballFlightTick);
+
+	finishedCurveballs.Reset();
+
+	for (int32 i = flights.Num() - 1; i >= 0; i--)
+	{
+		FCurveballFlight& flight = flights[i];
+
+		ACurveball* curveball = flight.curveball.Get();
+		if (curveball == NULL)
+		{
+			flights.RemoveAtSwap(i, 1, false);
+			DEC_DWORD_STAT(STAT_CurveballsInFlight);
+			continue;
+		}
+
+		flight.distance += flight.speed * DeltaTime;
+		curveball->SetFlightLocation(GetLocationAtDistance(flight, flight.distance));
+
+		if (flight.distance >= flight.arcLengths[FCurveballFlight::numArcLengthSamples])
+		{
+			finishedCurveballs.Add(flight.curveball);
+
+			flights.RemoveAtSwap(i, 1, false);
+			DEC_DWORD_STAT(STAT_CurveballsInFlight);
+		}
+	}
+
+	for (const TWeakObjectPtr<ACurveball>& finishedCurveball : finishedCurveballs)
+	{
+		if (finishedCurveball.IsValid())
+		{
+			finishedCurveball->curveballFlash();
+		}
+	}
+}
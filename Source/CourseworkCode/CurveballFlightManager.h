@@ -0,0 +1,84 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Tickable.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "CurveballFlightManager.generated.h"
+
+class ACurveball;
+
+/**
+ * quadratic Bezier flight path of one curveball, in the curveball's local space
+ * the arc length table lets the curveball travel along the curve at a constant speed
+ */
+struct FCurveballFlight
+{
+	// number of pieces the curve is split into when measuring its length
+	static constexpr int32 numArcLengthSamples = 8;
+
+	TWeakObjectPtr<ACurveball> curveball;
+
+	// start, control and end points of the curve
+	FVector start;
+	FVector control;
+	FVector end;
+
+	// length of the curve up to each sample, the first entry is always 0
+	float arcLengths[numArcLengthSamples + 1];
+
+	// distance travelled along the curve and the speed it is travelled at
+	float distance;
+	float speed;
+};
+
+/**
+ * World subsystem that flies every thrown Curveball along its curve in one update
+ * the curve is worked out from a closed form quadratic instead of a spline component per curveball
+ * and the curveball flashes once it reaches the end
+ */
+UCLASS(config=Game)
+class COURSEWORKCODE_API UCurveballFlightManager : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+
+	virtual void Deinitialize() override;
+
+	// starts flying the curveball through the three points, given in its local space
+	// the curve passes through the middle point halfway along, mirrored flips the curve to the left side
+	void StartFlight(ACurveball* curveball, const FVector& curveStart, const FVector& curvePoint, const FVector& curveEnd, float flightDuration, bool mirrored);
+
+	// stops flying the curveball without flashing
+	void StopFlight(ACurveball* curveball);
+
+	// number of curveballs in flight
+	int32 getNumFlights() const { return flights.Num(); }
+
+	// position on the curve after travelling the given distance along it
+	static FVector GetLocationAtDistance(const FCurveballFlight& flight, float distance);
+
+	// FTickableGameObject interface
+	virtual void Tick(float DeltaTime) override;
+	virtual ETickableTickType GetTickableTickType() const override { return ETickableTickType::Conditional; }
+	virtual bool IsTickable() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override { return GetWorld(); }
+	virtual TStatId GetStatId() const override;
+	// End of FTickableGameObject interface
+
+protected:
+
+	// position on the curve at the curve parameter, from 0 to 1
+	static FVector GetLocationAtParameter(const FCurveballFlight& flight, float t);
+
+	// fills in the arc length table of the flight
+	static void MeasureCurve(FCurveballFlight& flight);
+
+	// every curveball in flight
+	TArray<FCurveballFlight> flights;
+
+	// curveballs that reached the end this update, kept between frames to avoid reallocating
+	TArray<TWeakObjectPtr<ACurveball>> finishedCurveballs;
+};
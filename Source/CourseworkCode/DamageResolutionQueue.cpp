@@ -0,0 +1,225 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "DamageResolutionQueue.h"
+#include "CourseworkCode.h"
+#include "SageCube.h"
+#include "PlacedSageWall.h"
+#include "Components/PrimitiveComponent.h"
+#include "Engine/World.h"
+
+DECLARE_CYCLE_STAT(TEXT("Damage Queue Resolve"), STAT_DamageQueueResolve, STATGROUP_CourseworkCode);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Damage Records"), STAT_DamageQueueRecords, STATGROUP_CourseworkCode);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Damage Targets"), STAT_DamageQueueTargets, STATGROUP_CourseworkCode);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Impulse Records"), STAT_ImpulseQueueRecords, STATGROUP_CourseworkCode);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Impulse Targets"), STAT_ImpulseQueueTargets, STATGROUP_CourseworkCode);
+
+void UDamageResolutionQueue::Deinitialize()
+{
+	pendingDamage.Empty();
+	pendingImpulses.Empty();
+
+	Super::Deinitialize();
+}
+
+// only tick in game worlds when hits are waiting to be resolved
+bool UDamageResolutionQueue::IsTickable() const
+{
+	UWorld* const World = GetWorld();
+
+	return World != NULL && World->IsGameWorld() && (pendingDamage.Num() > 0 || pendingImpulses.Num() > 0);
+}
+
+TStatId UDamageResolutionQueue::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UDamageResolutionQueue, STATGROUP_Tickables);
+}
+
+void UDamageResolutionQueue::EnqueueDamage(AActor* target, int damageAmount, int32 targetItem)
+{
+	if (target != NULL)
+	{
+		pendingDamage.Add({ target, targetItem, damageAmount });
+	}
+}
+
+void UDamageResolutionQueue::EnqueueImpulse(UPrimitiveComponent* component, const FVector& impulse, const FVector& location)
+{
+	if (component != NULL)
+	{
+		pendingImpulses.Add({ component, impulse, location });
+	}
+}
+
+void UDamageResolutionQueue::QueueDamage(AActor* target, int damageAmount, int32 targetItem)
+{
+	if (target == NULL)
+	{
+		return;
+	}
+
+	UWorld* const World = target->GetWorld();
+	UDamageResolutionQueue* queue = World != NULL ? World->GetSubsystem<UDamageResolutionQueue>() : NULL;
+
+	if (queue != NULL)
+	{
+		queue->EnqueueDamage(target, damageAmount, targetItem);
+	}
+
+	else
+	{
+		ApplyDamage(target, GetTargetSegment(target, targetItem), damageAmount);
+	}
+}
+
+void UDamageResolutionQueue::QueueImpulse(UPrimitiveComponent* component, const FVector& impulse, const FVector& location)
+{
+	if (component == NULL)
+	{
+		return;
+	}
+
+	UWorld* const World = component->GetWorld();
+	UDamageResolutionQueue* queue = World != NULL ? World->GetSubsystem<UDamageResolutionQueue>() : NULL;
+
+	if (queue != NULL)
+	{
+		queue->EnqueueImpulse(component, impulse, location);
+	}
+
+	else
+	{
+		component->AddImpulseAtLocation(impulse, location);
+	}
+}
+
+// tickable objects tick after the physics scene, so every hit reported this frame is resolved together
+void UDamageResolutionQueue::Tick(float DeltaTime)
+{
+	ResolveQueue();
+}
+
+void UDamageResolutionQueue::ResolveQueue()
+{
+	SCOPE_CYCLE_COUNTER(STAT_DamageQueueResolve);
+
+	ResolveDamage();
+	ResolveImpulses();
+}
+
+// adds up the damage dealt to each target, then does one health change and one event per target
+// every instance hit within a target counts as its own target
+void UDamageResolutionQueue::ResolveDamage()
+{
+	INC_DWORD_STAT_BY(STAT_DamageQueueRecords, pendingDamage.Num());
+
+	struct FDamageTarget
+	{
+		AActor* actor;
+		int32 item;
+
+		bool operator==(const FDamageTarget& other) const { return actor == other.actor && item == other.item; }
+
+		friend uint32 GetTypeHash(const FDamageTarget& target) { return HashCombine(GetTypeHash(target.actor), ::GetTypeHash(target.item)); }
+	};
+
+	// maps keep the order keys were added in, so targets resolve in the order they were first hit
+	TMap<FDamageTarget, int, TInlineSetAllocator<32>> damagePerTarget;
+
+	for (const FQueuedDamage& record : pendingDamage)
+	{
+		AActor* target = record.target.Get();
+
+		if (target != NULL)
+		{
+			damagePerTarget.FindOrAdd({ target, record.targetItem }) += record.damageAmount;
+		}
+	}
+
+	// clear the records before the events are broadcast in case a listener queues more hits
+	pendingDamage.Reset();
+
+	INC_DWORD_STAT_BY(STAT_DamageQueueTargets, damagePerTarget.Num());
+
+	// destroying a wall segment changes the instance indices of the segments after it
+	// so every hit instance is turned into its health handle before any damage is applied
+	TArray<FSageCubeHealthHandle, TInlineAllocator<32>> targetSegments;
+	for (const TPair<FDamageTarget, int>& targetDamage : damagePerTarget)
+	{
+		targetSegments.Add(GetTargetSegment(targetDamage.Key.actor, targetDamage.Key.item));
+	}
+
+	int32 targetIndex = 0;
+	for (const TPair<FDamageTarget, int>& targetDamage : damagePerTarget)
+	{
+		const bool wasDestroyed = ApplyDamage(targetDamage.Key.actor, targetSegments[targetIndex++], targetDamage.Value);
+
+		OnDamageResolved.Broadcast(targetDamage.Key.actor, targetDamage.Value, wasDestroyed);
+	}
+}
+
+// adds up the impulses on each component into one linear and one angular impulse about its centre of mass
+// this gives the same result as adding each impulse at its own location
+void UDamageResolutionQueue::ResolveImpulses()
+{
+	INC_DWORD_STAT_BY(STAT_ImpulseQueueRecords, pendingImpulses.Num());
+
+	struct FSummedImpulse
+	{
+		FVector linearImpulse = FVector::ZeroVector;
+		FVector angularImpulse = FVector::ZeroVector;
+	};
+
+	TMap<UPrimitiveComponent*, FSummedImpulse, TInlineSetAllocator<32>> impulsePerComponent;
+
+	for (const FQueuedImpulse& record : pendingImpulses)
+	{
+		UPrimitiveComponent* component = record.component.Get();
+
+		// the component may have stopped simulating since the hit
+		if (component == NULL || !component->IsSimulatingPhysics())
+		{
+			continue;
+		}
+
+		FSummedImpulse& summed = impulsePerComponent.FindOrAdd(component);
+		summed.linearImpulse += record.impulse;
+		summed.angularImpulse += FVector::CrossProduct(record.location - component->GetCenterOfMass(), record.impulse);
+	}
+
+	pendingImpulses.Reset();
+
+	INC_DWORD_STAT_BY(STAT_ImpulseQueueTargets, impulsePerComponent.Num());
+
+	for (const TPair<UPrimitiveComponent*, FSummedImpulse>& componentImpulse : impulsePerComponent)
+	{
+		componentImpulse.Key->AddImpulse(componentImpulse.Value.linearImpulse);
+		componentImpulse.Key->AddAngularImpulseInRadians(componentImpulse.Value.angularImpulse);
+	}
+}
+
+FSageCubeHealthHandle UDamageResolutionQueue::GetTargetSegment(AActor* target, int32 targetItem)
+{
+	APlacedSageWall* placedWall = Cast<APlacedSageWall>(target);
+
+	return placedWall != NULL ? placedWall->GetSegmentHealthHandle(targetItem) : FSageCubeHealthHandle();
+}
+
+// takes the damage away from the target if it is a sage cube or a placed sage wall segment
+// the health registry sends the cube back to the pool, or removes the segment, once its health reaches 0
+bool UDamageResolutionQueue::ApplyDamage(AActor* target, const FSageCubeHealthHandle& targetSegment, int totalDamage)
+{
+	ASageCube* sageCube = Cast<ASageCube>(target);
+	if (sageCube != NULL)
+	{
+		return sageCube->ApplyCubeDamage(totalDamage);
+	}
+
+	APlacedSageWall* placedWall = Cast<APlacedSageWall>(target);
+	if (placedWall != NULL)
+	{
+		return placedWall->ApplySegmentDamage(targetSegment, totalDamage);
+	}
+
+	return false;
+}
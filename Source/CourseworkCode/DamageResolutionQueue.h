@@ -0,0 +1,94 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Tickable.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "SageCubeHealthRegistry.h"
+#include "DamageResolutionQueue.generated.h"
+
+class UPrimitiveComponent;
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_ThreeParams(FOnQueuedDamageResolved, AActor*, damagedActor, int, totalDamage, bool, wasDestroyed);
+
+/** damage dealt to one actor by a single hit */
+struct FQueuedDamage
+{
+	TWeakObjectPtr<AActor> target;
+
+	// instance hit within the target, INDEX_NONE if the whole actor was hit
+	int32 targetItem;
+
+	int damageAmount;
+};
+
+/** impulse added to one physics component by a single hit */
+struct FQueuedImpulse
+{
+	TWeakObjectPtr<UPrimitiveComponent> component;
+	FVector impulse;
+	FVector location;
+};
+
+/**
+ * World subsystem that collects the damage and impulses from hit callbacks during the frame
+ * and applies them in one pass, adding up every hit on the same target first
+ * targets are resolved in the order they were first hit so the result doesn't depend on the physics callback order
+ */
+UCLASS()
+class COURSEWORKCODE_API UDamageResolutionQueue : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+
+	virtual void Deinitialize() override;
+
+	// queues damage for the target, applied when the queue is resolved
+	// the target item picks out a single instance, such as one segment of a placed sage wall
+	void EnqueueDamage(AActor* target, int damageAmount, int32 targetItem = INDEX_NONE);
+
+	// queues an impulse at a world location for the component, applied when the queue is resolved
+	void EnqueueImpulse(UPrimitiveComponent* component, const FVector& impulse, const FVector& location);
+
+	// queues the damage in the target's world, or applies it straight away if that world has no queue
+	static void QueueDamage(AActor* target, int damageAmount, int32 targetItem = INDEX_NONE);
+
+	// queues the impulse in the component's world, or applies it straight away if that world has no queue
+	static void QueueImpulse(UPrimitiveComponent* component, const FVector& impulse, const FVector& location);
+
+	// applies every queued record straight away
+	void ResolveQueue();
+
+	/** called once per damaged actor each time the queue is resolved */
+	UPROPERTY(BlueprintAssignable)
+	FOnQueuedDamageResolved OnDamageResolved;
+
+	// FTickableGameObject interface
+	virtual void Tick(float DeltaTime) override;
+	virtual ETickableTickType GetTickableTickType() const override { return ETickableTickType::Conditional; }
+	virtual bool IsTickable() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override { return GetWorld(); }
+	virtual TStatId GetStatId() const override;
+	// End of FTickableGameObject interface
+
+protected:
+
+	// adds up the damage per target and applies it
+	void ResolveDamage();
+
+	// adds up the impulses per component and applies them
+	void ResolveImpulses();
+
+	// finds the health registry entry of the hit instance if the target is a placed sage wall
+	static FSageCubeHealthHandle GetTargetSegment(AActor* target, int32 targetItem);
+
+	// takes the damage away from the target's health, or from the segment's health if one is given
+	// returns true if the damage destroyed the target
+	static bool ApplyDamage(AActor* target, const FSageCubeHealthHandle& targetSegment, int totalDamage);
+
+	// hits queued this frame, in the order they were reported
+	TArray<FQueuedDamage> pendingDamage;
+	TArray<FQueuedImpulse> pendingImpulses;
+};
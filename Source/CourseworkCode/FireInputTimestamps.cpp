@@ -0,0 +1,402 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "FireInputTimestamps.h"
+#include "CourseworkCodeTestWorld.h"
+#include "FireScheduler.h"
+#include "FuryShot.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "Framework/Application/SlateApplication.h"
+#include "GameFramework/InputSettings.h"
+#include "GameFramework/ProjectileMovementComponent.h"
+#include "GameFramework/WorldSettings.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/App.h"
+#include "Misc/AutomationTest.h"
+
+#if PLATFORM_WINDOWS
+#include "Windows/WindowsApplication.h"
+#endif
+
+DEFINE_LOG_CATEGORY_STATIC(LogFireInput, Log, All);
+
+//////////////////////////////////////////////////////////////////////////
+// FFireInputMessageHandler
+
+#if PLATFORM_WINDOWS
+
+// passes the keyboard and mouse messages on to the timestamps, with the time the OS gave each message
+// handlers are called as the messages are pumped, before Slate defers them, so the message being handled is the current one
+class FFireInputMessageHandler : public IWindowsMessageHandler
+{
+public:
+
+	FFireInputMessageHandler(FFireInputTimestamps& inTimestamps)
+		: timestamps(inTimestamps)
+	{
+	}
+
+	virtual bool ProcessMessage(HWND hwnd, uint32 msg, WPARAM wParam, LPARAM lParam, int32& OutResult) override
+	{
+		switch (msg)
+		{
+		case WM_KEYDOWN:
+		case WM_SYSKEYDOWN:
+			// held keys repeat, only the first press counts
+			if ((lParam & 0x40000000) == 0)
+			{
+				timestamps.RecordKey(GetKeyFromMessage(wParam, lParam), true, GetMessageRealTime());
+			}
+			break;
+
+		case WM_KEYUP:
+		case WM_SYSKEYUP:
+			timestamps.RecordKey(GetKeyFromMessage(wParam, lParam), false, GetMessageRealTime());
+			break;
+
+		case WM_LBUTTONDOWN:
+		case WM_LBUTTONDBLCLK:
+			timestamps.RecordKey(EKeys::LeftMouseButton, true, GetMessageRealTime());
+			break;
+
+		case WM_LBUTTONUP:
+			timestamps.RecordKey(EKeys::LeftMouseButton, false, GetMessageRealTime());
+			break;
+
+		case WM_RBUTTONDOWN:
+		case WM_RBUTTONDBLCLK:
+			timestamps.RecordKey(EKeys::RightMouseButton, true, GetMessageRealTime());
+			break;
+
+		case WM_RBUTTONUP:
+			timestamps.RecordKey(EKeys::RightMouseButton, false, GetMessageRealTime());
+			break;
+
+		case WM_MBUTTONDOWN:
+		case WM_MBUTTONDBLCLK:
+			timestamps.RecordKey(EKeys::MiddleMouseButton, true, GetMessageRealTime());
+			break;
+
+		case WM_MBUTTONUP:
+			timestamps.RecordKey(EKeys::MiddleMouseButton, false, GetMessageRealTime());
+			break;
+
+		case WM_XBUTTONDOWN:
+		case WM_XBUTTONDBLCLK:
+			timestamps.RecordKey(GET_XBUTTON_WPARAM(wParam) == XBUTTON1 ? EKeys::ThumbMouseButton : EKeys::ThumbMouseButton2, true, GetMessageRealTime());
+			break;
+
+		case WM_XBUTTONUP:
+			timestamps.RecordKey(GET_XBUTTON_WPARAM(wParam) == XBUTTON1 ? EKeys::ThumbMouseButton : EKeys::ThumbMouseButton2, false, GetMessageRealTime());
+			break;
+		}
+
+		// the message is always passed on
+		return false;
+	}
+
+private:
+
+	// the message time is in milliseconds on the tick count clock, so its age is worked out on that clock
+	// and taken off the current high resolution time, the tick count only moves every 10 to 16 milliseconds
+	static double GetMessageRealTime()
+	{
+		const uint32 messageAge = uint32(::GetTickCount()) - uint32(::GetMessageTime());
+
+		return FPlatformTime::Seconds() - messageAge / 1000.0;
+	}
+
+	// works out the key the same way Slate does, which uses the left and right modifier keys instead of the shared ones
+	static FKey GetKeyFromMessage(WPARAM wParam, LPARAM lParam)
+	{
+		uint32 keyCode = uint32(wParam);
+		const bool isExtendedKey = (lParam & 0x01000000) != 0;
+
+		switch (keyCode)
+		{
+		case VK_SHIFT:
+			keyCode = ::MapVirtualKey((lParam & 0x00ff0000) >> 16, MAPVK_VSC_TO_VK_EX);
+			break;
+
+		case VK_CONTROL:
+			keyCode = isExtendedKey ? VK_RCONTROL : VK_LCONTROL;
+			break;
+
+		case VK_MENU:
+			keyCode = isExtendedKey ? VK_RMENU : VK_LMENU;
+			break;
+		}
+
+		return FInputKeyManager::Get().GetKeyFromCodes(keyCode, ::MapVirtualKey(keyCode, MAPVK_VK_TO_CHAR));
+	}
+
+	FFireInputTimestamps& timestamps;
+};
+
+#else
+
+// no platform message timestamps, so nothing is listened to
+class FFireInputMessageHandler
+{
+};
+
+#endif
+
+//////////////////////////////////////////////////////////////////////////
+// FFireInputTimestamps
+
+FFireInputTimestamps::FFireInputTimestamps(FName actionName)
+{
+	TArray<FInputActionKeyMapping> actionMappings;
+	UInputSettings::GetInputSettings()->GetActionMappingByName(actionName, actionMappings);
+
+	for (const FInputActionKeyMapping& mapping : actionMappings)
+	{
+		actionKeys.AddUnique(mapping.Key);
+	}
+}
+
+FFireInputTimestamps::~FFireInputTimestamps()
+{
+	Unregister();
+}
+
+// the tick count moves once per clock interrupt, and never by less than a millisecond
+double FFireInputTimestamps::GetTimestampResolution()
+{
+#if PLATFORM_WINDOWS
+	DWORD timeAdjustment = 0;
+	DWORD timeIncrement = 0;
+	BOOL isAdjustmentDisabled = 0;
+
+	// the increment is in 100 nanosecond units
+	if (::GetSystemTimeAdjustment(&timeAdjustment, &timeIncrement, &isAdjustmentDisabled) && timeIncrement > 0)
+	{
+		return FMath::Max(timeIncrement / 10000000.0, 0.001);
+	}
+
+	// the documented worst case
+	return 0.016;
+#else
+	return 0.0;
+#endif
+}
+
+bool FFireInputTimestamps::IsSupported(double maxResolution)
+{
+	const double resolution = GetTimestampResolution();
+	const bool isSupported = resolution > 0.0 && resolution <= maxResolution;
+
+	static bool hasLogged = false;
+	if (!isSupported && !hasLogged)
+	{
+		hasLogged = true;
+
+		if (resolution > 0.0)
+		{
+			UE_LOG(LogFireInput, Log, TEXT("Fire input isn't back-dated, input messages are stamped every %.1f ms, coarser than the %.1f ms limit"), resolution * 1000.0, maxResolution * 1000.0);
+		}
+
+		else
+		{
+			UE_LOG(LogFireInput, Log, TEXT("Fire input isn't back-dated, this platform doesn't stamp input messages"));
+		}
+	}
+
+	return isSupported;
+}
+
+bool FFireInputTimestamps::IsKeyboardUser(int32 controllerId)
+{
+	return FSlateApplication::IsInitialized() && controllerId == FSlateApplication::Get().GetUserIndexForKeyboard();
+}
+
+void FFireInputTimestamps::Register()
+{
+#if PLATFORM_WINDOWS
+	if (messageHandler.IsValid() || !FSlateApplication::IsInitialized())
+	{
+		return;
+	}
+
+	TSharedPtr<GenericApplication> platformApplication = FSlateApplication::Get().GetPlatformApplication();
+	if (!platformApplication.IsValid())
+	{
+		return;
+	}
+
+	messageHandler = MakeUnique<FFireInputMessageHandler>(*this);
+	static_cast<FWindowsApplication*>(platformApplication.Get())->AddMessageHandler(*messageHandler);
+#endif
+}
+
+void FFireInputTimestamps::Unregister()
+{
+#if PLATFORM_WINDOWS
+	if (!messageHandler.IsValid())
+	{
+		return;
+	}
+
+	if (FSlateApplication::IsInitialized())
+	{
+		TSharedPtr<GenericApplication> platformApplication = FSlateApplication::Get().GetPlatformApplication();
+		if (platformApplication.IsValid())
+		{
+			static_cast<FWindowsApplication*>(platformApplication.Get())->RemoveMessageHandler(*messageHandler);
+		}
+	}
+#endif
+
+	messageHandler.Reset();
+}
+
+void FFireInputTimestamps::RecordKey(const FKey& key, bool isPressed, double eventRealTime)
+{
+	if (actionKeys.Contains(key))
+	{
+		(isPressed ? pressTimes : releaseTimes).Add(eventRealTime);
+	}
+}
+
+bool FFireInputTimestamps::ConsumePressTime(const UWorld* World, double& outWorldTime)
+{
+	return ConsumeTime(World, pressTimes, outWorldTime);
+}
+
+bool FFireInputTimestamps::ConsumeReleaseTime(const UWorld* World, double& outWorldTime)
+{
+	return ConsumeTime(World, releaseTimes, outWorldTime);
+}
+
+void FFireInputTimestamps::Reset()
+{
+	pressTimes.Reset();
+	releaseTimes.Reset();
+}
+
+bool FFireInputTimestamps::ConsumeTime(const UWorld* World, TArray<double>& times, double& outWorldTime)
+{
+	if (World == NULL || times.Num() == 0)
+	{
+		return false;
+	}
+
+	const AWorldSettings* worldSettings = World->GetWorldSettings();
+	const float timeDilation = worldSettings != NULL ? worldSettings->GetEffectiveTimeDilation() : 1.0f;
+
+	outWorldTime = ToWorldTime(times[0], FApp::GetCurrentTime(), FApp::GetDeltaTime(), World->GetTimeSeconds(), timeDilation);
+	times.RemoveAt(0, 1, false);
+
+	return true;
+}
+
+double FFireInputTimestamps::ToWorldTime(double eventRealTime, double frameRealTime, double frameRealDeltaTime, double frameWorldTime, float timeDilation)
+{
+	// events recorded after the frame started are treated as happening at the start of the frame
+	const double eventAge = FMath::Clamp(frameRealTime - eventRealTime, 0.0, frameRealDeltaTime);
+
+	return frameWorldTime - eventAge * timeDilation;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Tests
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFireInputBackdatedShotTest, "CourseworkCode.FireInput.BackdatedShotPlacement", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+namespace FireInputTests
+{
+	// position of a shot fired at the given velocity once it has flown for the given time
+	// worked out here rather than with the shot kernel, so the kernel is checked as well
+	static FVector GetExactShotPosition(const FVector& startLocation, const FVector& velocity, float gravityZ, float flightTime)
+	{
+		return startLocation + velocity * flightTime + FVector(0.0f, 0.0f, 0.5f * gravityZ * flightTime * flightTime);
+	}
+
+	// fires a burst from synthetic timestamped input at a fixed frame rate
+	// every due shot is spawned as a real fury shot at the end of its frame and moved on by its age, the way the fire pipeline does
+	// the result is compared with where the shot would be if it had been fired at its exact time
+	static void RunBurst(const FCourseworkCodeTestWorld& testWorld, float framesPerSecond, double fireInterval, int32& outNumShots, float& outMaxError)
+	{
+		const double pressTime = 0.0123;
+		const double releaseTime = 1.0037;
+		const double frameTime = 1.0 / framesPerSecond;
+		const FVector muzzleLocation(0.0f, 0.0f, 10000.0f);
+
+		FFireScheduler scheduler;
+		scheduler.maxShotsPerAdvance = MAX_int32;
+		scheduler.SetFireInterval(fireInterval, 0.0);
+
+		TArray<double> shotTimes;
+		outNumShots = 0;
+		outMaxError = 0.0f;
+
+		// real and world time run together, frames end at every multiple of the frame time
+		for (double frameEnd = frameTime; frameEnd < releaseTime + 2.0 * frameTime; frameEnd += frameTime)
+		{
+			const double frameStart = frameEnd - frameTime;
+
+			// input handled this frame happened at some point during the last frame
+			if (pressTime > frameStart && pressTime <= frameEnd)
+			{
+				scheduler.StartFiring(FFireInputTimestamps::ToWorldTime(pressTime, frameEnd, frameTime, frameEnd, 1.0f));
+			}
+
+			if (releaseTime > frameStart && releaseTime <= frameEnd)
+			{
+				scheduler.StopFiring(FFireInputTimestamps::ToWorldTime(releaseTime, frameEnd, frameTime, frameEnd, 1.0f));
+			}
+
+			shotTimes.Reset();
+			scheduler.Advance(frameEnd, shotTimes);
+
+			for (double shotTime : shotTimes)
+			{
+				AFuryShot* furyShot = testWorld.SpawnActor<AFuryShot>(FTransform(muzzleLocation));
+				if (furyShot == NULL)
+				{
+					continue;
+				}
+
+				const UProjectileMovementComponent* projectileMovement = furyShot->FindComponentByClass<UProjectileMovementComponent>();
+				const FVector launchVelocity = projectileMovement->Velocity;
+				const float gravityZ = projectileMovement->GetGravityZ();
+
+				furyShot->AdvanceSpawnTime(float(frameEnd - shotTime));
+
+				const double exactFireTime = pressTime + outNumShots * fireInterval;
+				const FVector exactPosition = GetExactShotPosition(muzzleLocation, launchVelocity, gravityZ, float(frameEnd - exactFireTime));
+
+				outMaxError = FMath::Max(outMaxError, FVector::Dist(furyShot->GetActorLocation(), exactPosition));
+				outNumShots++;
+
+				furyShot->Destroy();
+			}
+		}
+	}
+}
+
+bool FFireInputBackdatedShotTest::RunTest(const FString& Parameters)
+{
+	FCourseworkCodeTestWorld testWorld;
+
+	const double fireInterval = 0.1;
+	const int32 expectedShots = FMath::CeilToInt(float((1.0037 - 0.0123) / fireInterval));
+
+	for (float framesPerSecond : { 8.0f, 15.0f, 30.0f, 60.0f, 144.0f, 240.0f })
+	{
+		int32 numShots;
+		float maxError;
+		FireInputTests::RunBurst(testWorld, framesPerSecond, fireInterval, numShots, maxError);
+
+		TestEqual(FString::Printf(TEXT("Shots fired at %.0f fps"), framesPerSecond), numShots, expectedShots);
+		TestTrue(FString::Printf(TEXT("Back-dated shots at %.0f fps are within 1 unit of their exact position (%.3f)"), framesPerSecond, maxError), maxError < 1.0f);
+	}
+
+	return true;
+}
+
+#endif
@@ -0,0 +1,74 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "InputCoreTypes.h"
+
+class FFireInputMessageHandler;
+
+/**
+ * Records the time every key mapped to an action is pressed and released
+ * input bindings only run once per frame, so these times let a shot be placed where it was actually fired within the frame
+ * the times are taken from the timestamp the OS gives each input message, not from when the message is handled,
+ * since every message is only handled when the messages are pumped at the start of the next frame
+ * only Windows gives input messages a timestamp, and it is on the tick count clock, which only moves every 10 to 16 milliseconds
+ * a clock that coarse is off by as much as the back-dating corrects, so callers check IsSupported against the resolution they need
+ * on other platforms, or with a coarse clock, nothing is recorded and shots are fired at the frame time
+ * keyboard and mouse messages can't tell local players apart, so only the keyboard user's character should record times
+ * messages are never consumed, so normal input handling is unchanged
+ */
+class COURSEWORKCODE_API FFireInputTimestamps
+{
+public:
+
+	// records the keys mapped to the given action in the input settings
+	FFireInputTimestamps(FName actionName);
+
+	~FFireInputTimestamps();
+
+	// time in seconds between ticks of the clock the platform stamps input messages with, 0 if messages have no timestamp
+	static double GetTimestampResolution();
+
+	// true if the platform's input messages have a timestamp at least as fine as the given resolution
+	// logs the first time it isn't, so it is clear why shots are fired at the frame time
+	static bool IsSupported(double maxResolution);
+
+	// true if the local player with the given controller id gets the keyboard and mouse input
+	static bool IsKeyboardUser(int32 controllerId);
+
+	// starts and stops listening to the platform's input messages
+	void Register();
+	void Unregister();
+
+	// records a press or release at the given real time if the key is mapped to the action
+	void RecordKey(const FKey& key, bool isPressed, double eventRealTime);
+
+	// takes the oldest press or release time recorded and converts it to world time
+	// returns false if no time was recorded, e.g. for touch or gamepad input
+	bool ConsumePressTime(const UWorld* World, double& outWorldTime);
+	bool ConsumeReleaseTime(const UWorld* World, double& outWorldTime);
+
+	// clears any times left over once the frame's input has been handled
+	void Reset();
+
+	// converts a real time recorded during the last frame to world time
+	// the frame's real start time lines up with the frame's world time, earlier events are moved back by the time between them
+	// scaled by time dilation and never further back than the start of the last frame
+	static double ToWorldTime(double eventRealTime, double frameRealTime, double frameRealDeltaTime, double frameWorldTime, float timeDilation);
+
+private:
+
+	// takes the oldest time from the list and converts it to world time
+	static bool ConsumeTime(const UWorld* World, TArray<double>& times, double& outWorldTime);
+
+	// keys mapped to the action
+	TArray<FKey> actionKeys;
+
+	// real times of the presses and releases since the last reset, oldest first
+	TArray<double> pressTimes;
+	TArray<double> releaseTimes;
+
+	// listens to the platform's input messages while registered
+	TUniquePtr<FFireInputMessageHandler> messageHandler;
+};
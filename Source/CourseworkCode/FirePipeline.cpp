@@ -0,0 +1,165 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "FirePipeline.h"
+#include "CourseworkCode.h"
+#include "CourseworkCodeCharacter.h"
+#include "Animation/AnimInstance.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Engine/World.h"
+#include "Kismet/GameplayStatics.h"
+#include "Sound/SoundBase.h"
+
+DECLARE_CYCLE_STAT(TEXT("Fire Pipeline Spawn Pass"), STAT_FirePipelineSpawn, STATGROUP_CourseworkCode);
+DECLARE_CYCLE_STAT(TEXT("Fire Pipeline Audio Pass"), STAT_FirePipelineAudio, STATGROUP_CourseworkCode);
+DECLARE_CYCLE_STAT(TEXT("Fire Pipeline Animation Pass"), STAT_FirePipelineAnimation, STATGROUP_CourseworkCode);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Fire Requests"), STAT_FirePipelineRequests, STATGROUP_CourseworkCode);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Fire Sounds Played"), STAT_FirePipelineSoundsPlayed, STATGROUP_CourseworkCode);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Fire Sounds Deduped"), STAT_FirePipelineSoundsDeduped, STATGROUP_CourseworkCode);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Fire Montages Played"), STAT_FirePipelineMontagesPlayed, STATGROUP_CourseworkCode);
+
+// sets default pipeline settings, these can be overridden in DefaultGame.ini
+UFirePipeline::UFirePipeline()
+{
+	audioDedupeRadius = 50.0f;
+
+	// same volume the character used to play the fire sound with
+	fireSoundVolume = 0.1f;
+
+	// long hitches are not made up for, the shots would appear far from the muzzle
+	maxSpawnBackdate = 0.1f;
+}
+
+void UFirePipeline::Deinitialize()
+{
+	pendingRequests.Empty();
+
+	Super::Deinitialize();
+}
+
+// only tick in game worlds when shots are waiting to be resolved
+bool UFirePipeline::IsTickable() const
+{
+	UWorld* const World = GetWorld();
+
+	return World != NULL && World->IsGameWorld() && pendingRequests.Num() > 0;
+}
+
+TStatId UFirePipeline::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UFirePipeline, STATGROUP_Tickables);
+}
+
+void UFirePipeline::SubmitFireRequest(const FFireRequest& request)
+{
+	pendingRequests.Add(request);
+}
+
+// tickable objects tick after every actor, so all shots fired this frame are resolved together
+void UFirePipeline::Tick(float DeltaTime)
+{
+	ResolveFireRequests();
+}
+
+void UFirePipeline::ResolveFireRequests()
+{
+	INC_DWORD_STAT_BY(STAT_FirePipelineRequests, pendingRequests.Num());
+
+	RunSpawnPass();
+	RunAudioPass();
+	RunAnimationPass();
+
+	pendingRequests.Reset();
+}
+
+// spawns every projectile in one go
+void UFirePipeline::RunSpawnPass()
+{
+	SCOPE_CYCLE_COUNTER(STAT_FirePipelineSpawn);
+
+	const double earliestFireTime = GetWorld()->GetTimeSeconds() - maxSpawnBackdate;
+
+	for (const FFireRequest& request : pendingRequests)
+	{
+		ACourseworkCodeCharacter* shooter = request.shooter.Get();
+
+		if (shooter != NULL && request.spawnProjectile)
+		{
+			shooter->SpawnFuryShot(request.spawnLocation, request.spawnRotation, FMath::Max(request.fireTime, earliestFireTime));
+		}
+	}
+}
+
+// plays the fire sounds, skipping any that would play on top of one already played this frame
+void UFirePipeline::RunAudioPass()
+{
+	SCOPE_CYCLE_COUNTER(STAT_FirePipelineAudio);
+
+	struct FPlayedSound
+	{
+		USoundBase* sound;
+		FVector location;
+	};
+
+	TArray<FPlayedSound, TInlineAllocator<32>> playedSounds;
+	const float dedupeRadiusSquared = FMath::Square(audioDedupeRadius);
+
+	for (const FFireRequest& request : pendingRequests)
+	{
+		ACourseworkCodeCharacter* shooter = request.shooter.Get();
+
+		// try and play the sound if specified
+		if (shooter == NULL || shooter->FireSound == NULL)
+		{
+			continue;
+		}
+
+		const FVector soundLocation = shooter->GetActorLocation();
+
+		// the same sound from the same spot this frame would only stack up
+		const bool alreadyPlayed = playedSounds.ContainsByPredicate([&](const FPlayedSound& played)
+		{
+			return played.sound == shooter->FireSound && FVector::DistSquared(played.location, soundLocation) <= dedupeRadiusSquared;
+		});
+
+		if (alreadyPlayed)
+		{
+			INC_DWORD_STAT(STAT_FirePipelineSoundsDeduped);
+			continue;
+		}
+
+		UGameplayStatics::PlaySoundAtLocation(shooter, shooter->FireSound, soundLocation, fireSoundVolume);
+		playedSounds.Add({ shooter->FireSound, soundLocation });
+
+		INC_DWORD_STAT(STAT_FirePipelineSoundsPlayed);
+	}
+}
+
+// restarts the fire montage once on every arms mesh that fired this frame
+void UFirePipeline::RunAnimationPass()
+{
+	SCOPE_CYCLE_COUNTER(STAT_FirePipelineAnimation);
+
+	TArray<UAnimInstance*, TInlineAllocator<32>> animatedInstances;
+
+	for (const FFireRequest& request : pendingRequests)
+	{
+		ACourseworkCodeCharacter* shooter = request.shooter.Get();
+
+		// try and play a firing animation if specified
+		if (shooter == NULL || shooter->FireAnimation == NULL)
+		{
+			continue;
+		}
+
+		// Get the animation object for the arms mesh
+		UAnimInstance* AnimInstance = shooter->GetMesh1P()->GetAnimInstance();
+		if (AnimInstance != NULL && !animatedInstances.Contains(AnimInstance))
+		{
+			AnimInstance->Montage_Play(shooter->FireAnimation, 1.f);
+			animatedInstances.Add(AnimInstance);
+
+			INC_DWORD_STAT(STAT_FirePipelineMontagesPlayed);
+		}
+	}
+}
@@ -0,0 +1,83 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Tickable.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "FirePipeline.generated.h"
+
+class ACourseworkCodeCharacter;
+
+/** a single shot submitted by a shooter, resolved by the fire pipeline at the end of the frame */
+struct FFireRequest
+{
+	// player or bot that fired the shot
+	TWeakObjectPtr<ACourseworkCodeCharacter> shooter;
+
+	// muzzle location and aim rotation when the shot was fired
+	FVector spawnLocation;
+	FRotator spawnRotation;
+
+	// world time the shot was fired at, can be earlier than the current frame time
+	double fireTime;
+
+	// false if the shooter has no projectile class, only the sound and animation are played
+	bool spawnProjectile;
+};
+
+/**
+ * World subsystem that collects the shots fired by every shooter during the frame
+ * and resolves them in stages: one spawn pass, one audio pass and one animation pass
+ */
+UCLASS(config=Game)
+class COURSEWORKCODE_API UFirePipeline : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+
+	UFirePipeline();
+
+	virtual void Deinitialize() override;
+
+	// queues a shot to be resolved at the end of the frame
+	void SubmitFireRequest(const FFireRequest& request);
+
+	// resolves every queued shot straight away
+	void ResolveFireRequests();
+
+	// FTickableGameObject interface
+	virtual void Tick(float DeltaTime) override;
+	virtual ETickableTickType GetTickableTickType() const override { return ETickableTickType::Conditional; }
+	virtual bool IsTickable() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override { return GetWorld(); }
+	virtual TStatId GetStatId() const override;
+	// End of FTickableGameObject interface
+
+protected:
+
+	/** fire sounds closer together than this in the same frame are only played once */
+	UPROPERTY(config)
+	float audioDedupeRadius;
+
+	/** volume the fire sound is played at */
+	UPROPERTY(config)
+	float fireSoundVolume;
+
+	/** longest time a shot is moved forward by to make up for being fired earlier in the frame */
+	UPROPERTY(config)
+	float maxSpawnBackdate;
+
+	// spawns the projectile for every request, back-dated to the time it was fired
+	void RunSpawnPass();
+
+	// plays the fire sound once per shooter location, skipping duplicates in the same frame
+	void RunAudioPass();
+
+	// plays the fire animation once per animation instance
+	void RunAnimationPass();
+
+	// shots fired this frame
+	TArray<FFireRequest> pendingRequests;
+};
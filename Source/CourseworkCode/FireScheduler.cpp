@@ -0,0 +1,152 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "FireScheduler.h"
+#include "Misc/AutomationTest.h"
+
+FFireScheduler::FFireScheduler()
+{
+	maxShotsPerAdvance = 16;
+
+	fireInterval = 0.175f;
+	isFiring = false;
+	releaseTime = 0.0;
+
+	// no shot has been fired yet so the first one is never held back
+	lastShotTime = -DBL_MAX;
+	nextShotTime = 0.0;
+	lastAdvanceTime = 0.0;
+}
+
+// changes the fire rate, keeping the time of the last shot as the reference point
+void FFireScheduler::SetFireInterval(float newFireInterval, double changeTime)
+{
+	fireInterval = FMath::Max(newFireInterval, KINDA_SMALL_NUMBER);
+
+	if (isFiring && lastShotTime > -DBL_MAX)
+	{
+		// the next shot is one new interval after the last one
+		// but never earlier than the moment the rate changed
+		nextShotTime = FMath::Max(lastShotTime + fireInterval, FMath::Max(changeTime, lastAdvanceTime));
+	}
+}
+
+// starts a new burst, honouring the fire rate if the last shot was very recent
+void FFireScheduler::StartFiring(double pressTime)
+{
+	// pressed again before a pending release was processed, so carry on with the same burst
+	if (isFiring)
+	{
+		releaseTime = DBL_MAX;
+		return;
+	}
+
+	isFiring = true;
+	releaseTime = DBL_MAX;
+
+	// shots can't be placed in a part of the timeline that has already been advanced through
+	const double startTime = FMath::Max(pressTime, lastAdvanceTime);
+
+	nextShotTime = lastShotTime > -DBL_MAX ? FMath::Max(lastShotTime + fireInterval, startTime) : startTime;
+}
+
+// marks the end of the burst
+void FFireScheduler::StopFiring(double inReleaseTime)
+{
+	releaseTime = FMath::Max(inReleaseTime, lastAdvanceTime);
+}
+
+// fires every shot due between the last advance and the end of this frame
+int32 FFireScheduler::Advance(double frameEndTime, TArray<double>& outShotTimes)
+{
+	int32 numShots = 0;
+
+	while (isFiring && nextShotTime <= frameEndTime && nextShotTime < releaseTime)
+	{
+		// after a long hitch skip ahead instead of firing the whole backlog at once
+		if (numShots >= maxShotsPerAdvance)
+		{
+			nextShotTime = frameEndTime + fireInterval;
+			break;
+		}
+
+		outShotTimes.Add(nextShotTime);
+		numShots++;
+
+		lastShotTime = nextShotTime;
+		nextShotTime += fireInterval;
+	}
+
+	// the burst is over once every shot before the release has been fired
+	if (isFiring && nextShotTime >= releaseTime)
+	{
+		isFiring = false;
+	}
+
+	lastAdvanceTime = FMath::Max(lastAdvanceTime, frameEndTime);
+
+	return numShots;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Tests
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFireSchedulerFrameRateTest, "CourseworkCode.FireScheduler.ShotsPerSecondAtFrameRates", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+namespace FireSchedulerTests
+{
+	// holds the trigger for the given time, advancing the scheduler once per frame at a fixed frame rate
+	// returns the number of shots fired
+	static int32 HoldTrigger(float framesPerSecond, float fireInterval, double holdTime)
+	{
+		const double frameTime = 1.0 / framesPerSecond;
+
+		FFireScheduler scheduler;
+		scheduler.SetFireInterval(fireInterval, 0.0);
+		scheduler.StartFiring(0.0);
+
+		TArray<double> shotTimes;
+		bool isReleased = false;
+
+		// frame end times are worked out from the frame number so they don't drift
+		for (int32 frame = 0; scheduler.IsFiring(); frame++)
+		{
+			const double frameEnd = frame * frameTime;
+
+			if (!isReleased && frameEnd >= holdTime)
+			{
+				scheduler.StopFiring(holdTime);
+				isReleased = true;
+			}
+
+			scheduler.Advance(frameEnd, shotTimes);
+		}
+
+		return shotTimes.Num();
+	}
+}
+
+bool FFireSchedulerFrameRateTest::RunTest(const FString& Parameters)
+{
+	// kept off a whole number of intervals so the last shot isn't on the release time
+	const double holdTime = 10.05;
+
+	// the standard and fury fire rates
+	for (float fireInterval : { 0.175f, 0.1f })
+	{
+		const int32 expectedShots = FMath::CeilToInt(float(holdTime / fireInterval));
+
+		for (float framesPerSecond : { 30.0f, 60.0f, 240.0f })
+		{
+			const int32 numShots = FireSchedulerTests::HoldTrigger(framesPerSecond, fireInterval, holdTime);
+
+			TestEqual(FString::Printf(TEXT("Shots in %.2f seconds at %.3f second interval and %.0f fps"), holdTime, fireInterval, framesPerSecond), numShots, expectedShots);
+		}
+	}
+
+	return true;
+}
+
+#endif
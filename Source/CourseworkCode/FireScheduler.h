@@ -0,0 +1,56 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Works out when automatic fire shots are due using elapsed time instead of a polling timer
+ * all times are in world seconds, so the number of shots fired doesn't depend on the frame rate
+ */
+struct COURSEWORKCODE_API FFireScheduler
+{
+public:
+
+	FFireScheduler();
+
+	// sets the time between shots
+	// the next shot is rescheduled from the last shot fired, so switching rates mid-burst doesn't skip or double up a shot
+	void SetFireInterval(float newFireInterval, double changeTime);
+
+	// starts firing from the given time
+	// the first shot fires straight away unless the last shot was less than one interval ago
+	void StartFiring(double pressTime);
+
+	// stops firing, shots due before the release time are still fired by the next advance
+	void StopFiring(double releaseTime);
+
+	// moves the scheduler up to the end of the frame and adds the time of every shot that became due
+	// returns the number of shots added
+	int32 Advance(double frameEndTime, TArray<double>& outShotTimes);
+
+	bool IsFiring() const { return isFiring; }
+
+	float GetFireInterval() const { return fireInterval; }
+
+	// shots a single advance is allowed to fire, stops a long hitch from emptying a burst in one frame
+	int32 maxShotsPerAdvance;
+
+private:
+
+	float fireInterval;
+
+	bool isFiring;
+
+	// time the trigger was released, shots at or after this time are not fired
+	double releaseTime;
+
+	// time of the last shot fired
+	double lastShotTime;
+
+	// time the next shot is due
+	double nextShotTime;
+
+	// end time of the last advance, shots can't be scheduled before this
+	double lastAdvanceTime;
+};
@@ -0,0 +1,225 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "FlashEffectComponent.h"
+#include "CourseworkCode.h"
+#include "Engine/World.h"
+#include "GameFramework/Pawn.h"
+#include "Materials/MaterialParameterCollection.h"
+#include "Materials/MaterialParameterCollectionInstance.h"
+#include "Misc/AutomationTest.h"
+#include "UObject/ConstructorHelpers.h"
+#include "UObject/Package.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Flash Parameter Writes"), STAT_FlashParameterWrites, STATGROUP_CourseworkCode);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Flash Parameter Writes Skipped"), STAT_FlashParameterWritesSkipped, STATGROUP_CourseworkCode);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Active Flashes"), STAT_ActiveFlashes, STATGROUP_CourseworkCode);
+
+// sets default flash settings, these can be overridden in DefaultGame.ini
+UFlashEffectComponent::UFlashEffectComponent()
+{
+	// only ticks while a flash is fading out
+	PrimaryComponentTick.bCanEverTick = true;
+	PrimaryComponentTick.bStartWithTickEnabled = false;
+
+	flashParameters = NULL;
+
+	static ConstructorHelpers::FObjectFinder<UMaterialParameterCollection> flashParametersAsset(TEXT("/Game/FirstPersonCPP/Blueprints/FlashParams"));
+	if (flashParametersAsset.Succeeded())
+	{
+		flashParameters = flashParametersAsset.Object;
+	}
+
+	flashParameterName = TEXT("Flash Value");
+
+	// fades straight out by default, the curve can be reshaped on the character
+	decayCurve.GetRichCurve()->AddKey(0.0f, 1.0f);
+	decayCurve.GetRichCurve()->AddKey(1.0f, 0.0f);
+
+	flashDuration = 2.0f;
+	maxStackedAmount = 3.0f;
+	maxActiveFlashes = 8;
+	parameterChangeThreshold = 0.001f;
+
+	flashParametersInstance = NULL;
+	flashValue = 0.0f;
+	lastPushedValue = 0.0f;
+}
+
+void UFlashEffectComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	UWorld* const World = GetWorld();
+	if (World != NULL && flashParameters != NULL)
+	{
+		flashParametersInstance = World->GetParameterCollectionInstance(flashParameters);
+	}
+}
+
+void UFlashEffectComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	DEC_DWORD_STAT_BY(STAT_ActiveFlashes, activeFlashes.Num());
+	activeFlashes.Reset();
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void UFlashEffectComponent::AddFlash(float amount)
+{
+	UWorld* const World = GetWorld();
+
+	AddFlashAt(amount, World != NULL ? World->GetTimeSeconds() : 0.0f);
+}
+
+void UFlashEffectComponent::AddFlashAt(float amount, float startTime)
+{
+	if (amount == 0.0f)
+	{
+		return;
+	}
+
+	if (activeFlashes.Num() >= FMath::Max(maxActiveFlashes, 1))
+	{
+		activeFlashes.RemoveAt(0, 1, false);
+		DEC_DWORD_STAT(STAT_ActiveFlashes);
+	}
+
+	FActiveFlash flash;
+	flash.amount = amount;
+	flash.startTime = startTime;
+	activeFlashes.Add(flash);
+
+	INC_DWORD_STAT(STAT_ActiveFlashes);
+
+	SetComponentTickEnabled(true);
+}
+
+// the decay curve is sampled at each flash's age as a fraction of the flash duration
+float UFlashEffectComponent::EvaluateAt(float time) const
+{
+	const FRichCurve* curve = decayCurve.GetRichCurveConst();
+	const float duration = FMath::Max(flashDuration, KINDA_SMALL_NUMBER);
+
+	float value = 0.0f;
+	for (const FActiveFlash& flash : activeFlashes)
+	{
+		const float lifeFraction = (time - flash.startTime) / duration;
+		if (lifeFraction < 0.0f || lifeFraction >= 1.0f)
+		{
+			continue;
+		}
+
+		value += flash.amount * (curve != NULL ? curve->Eval(lifeFraction) : 1.0f - lifeFraction);
+	}
+
+	return FMath::Clamp(value, -maxStackedAmount, maxStackedAmount);
+}
+
+void UFlashEffectComponent::RemoveFinishedFlashes(float time)
+{
+	const float duration = FMath::Max(flashDuration, KINDA_SMALL_NUMBER);
+
+	const int32 numRemoved = activeFlashes.RemoveAll([time, duration](const FActiveFlash& flash)
+	{
+		return time - flash.startTime >= duration;
+	});
+
+	DEC_DWORD_STAT_BY(STAT_ActiveFlashes, numRemoved);
+}
+
+void UFlashEffectComponent::ClearFlashes()
+{
+	DEC_DWORD_STAT_BY(STAT_ActiveFlashes, activeFlashes.Num());
+	activeFlashes.Reset();
+
+	flashValue = 0.0f;
+	PushFlashValue(flashValue);
+
+	SetComponentTickEnabled(false);
+}
+
+void UFlashEffectComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	const float time = GetWorld()->GetTimeSeconds();
+
+	RemoveFinishedFlashes(time);
+
+	flashValue = activeFlashes.Num() > 0 ? EvaluateAt(time) : 0.0f;
+	PushFlashValue(flashValue);
+
+	// the last frame always writes 0, so the tick can stop once every flash has finished
+	if (activeFlashes.Num() == 0)
+	{
+		SetComponentTickEnabled(false);
+	}
+}
+
+// the collection is shared by every character in the world, so only the local player's flash is shown
+void UFlashEffectComponent::PushFlashValue(float value)
+{
+	const APawn* ownerPawn = Cast<APawn>(GetOwner());
+	if (flashParametersInstance == NULL || ownerPawn == NULL || !ownerPawn->IsLocallyControlled())
+	{
+		return;
+	}
+
+	// a flash ending is always written so the screen goes fully back to normal
+	const bool isClearing = value == 0.0f && lastPushedValue != 0.0f;
+	if (!isClearing && FMath::IsNearlyEqual(value, lastPushedValue, parameterChangeThreshold))
+	{
+		INC_DWORD_STAT(STAT_FlashParameterWritesSkipped);
+		return;
+	}
+
+	flashParametersInstance->SetScalarParameterValue(flashParameterName, value);
+	lastPushedValue = value;
+
+	INC_DWORD_STAT(STAT_FlashParameterWrites);
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Tests
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFlashEffectDecayTest, "CourseworkCode.FlashEffect.DecayAndStacking", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+// checks the decay and stacking on a component that isn't in a world, using explicit times
+bool FFlashEffectDecayTest::RunTest(const FString& Parameters)
+{
+	UFlashEffectComponent* flashEffect = NewObject<UFlashEffectComponent>(GetTransientPackage());
+
+	// one flash fades from its full amount down to nothing
+	flashEffect->AddFlashAt(-1.0f, 10.0f);
+
+	const float atStart = flashEffect->EvaluateAt(10.0f);
+	const float halfway = flashEffect->EvaluateAt(10.5f);
+	const float later = flashEffect->EvaluateAt(11.0f);
+
+	TestEqual(TEXT("A flash starts at its full amount"), atStart, -1.0f);
+	TestTrue(TEXT("A flash only ever fades"), FMath::Abs(halfway) <= FMath::Abs(atStart) && FMath::Abs(later) <= FMath::Abs(halfway));
+	TestEqual(TEXT("A flash does nothing before it starts"), flashEffect->EvaluateAt(9.0f), 0.0f);
+	TestEqual(TEXT("A flash has finished after its duration"), flashEffect->EvaluateAt(1000.0f), 0.0f);
+
+	// a second flash on top adds to the first
+	flashEffect->AddFlashAt(-0.5f, 10.5f);
+	TestEqual(TEXT("Overlapping flashes add together"), flashEffect->EvaluateAt(10.5f), halfway - 0.5f);
+
+	// enough flashes at once are held at the stacking limit
+	for (int32 i = 0; i < 20; i++)
+	{
+		flashEffect->AddFlashAt(-10.0f, 10.5f);
+	}
+	TestTrue(TEXT("Stacked flashes are clamped"), FMath::Abs(flashEffect->EvaluateAt(10.5f)) <= flashEffect->getMaxStackedAmount() + KINDA_SMALL_NUMBER);
+	TestEqual(TEXT("The oldest flashes are dropped to make room"), flashEffect->getNumActiveFlashes(), flashEffect->getMaxActiveFlashes());
+
+	flashEffect->RemoveFinishedFlashes(1000.0f);
+	TestEqual(TEXT("Finished flashes are removed"), flashEffect->getNumActiveFlashes(), 0);
+
+	return true;
+}
+
+#endif
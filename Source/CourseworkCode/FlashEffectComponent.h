@@ -0,0 +1,117 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "Curves/CurveFloat.h"
+#include "FlashEffectComponent.generated.h"
+
+class UMaterialParameterCollection;
+class UMaterialParameterCollectionInstance;
+
+/** one flash still fading out on a listener */
+struct FActiveFlash
+{
+	// flash amount at the moment of the flash
+	float amount;
+
+	// world time the flash went off
+	float startTime;
+};
+
+/**
+ * Flash effect on a character, replacing the Blueprint flash event and timeline
+ * every flash fades out along the decay curve, flashes that overlap are added together
+ * the result is written to the flash material parameter collection, but only when it has actually changed
+ * and only for the locally controlled character, since the collection is shared by the whole world
+ * the component only ticks while a flash is fading out
+ */
+UCLASS(config=Game, ClassGroup=(Custom), meta=(BlueprintSpawnableComponent))
+class COURSEWORKCODE_API UFlashEffectComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+
+	UFlashEffectComponent();
+
+	// starts a flash of the given amount now
+	UFUNCTION(BlueprintCallable)
+	void AddFlash(float amount);
+
+	// starts a flash of the given amount at the given world time
+	void AddFlashAt(float amount, float startTime);
+
+	// flash value at the given world time from every flash still fading out
+	float EvaluateAt(float time) const;
+
+	// forgets flashes that have finished fading out by the given world time
+	void RemoveFinishedFlashes(float time);
+
+	// forgets every flash and clears the flash parameter
+	void ClearFlashes();
+
+	// flash value last worked out
+	UFUNCTION(BlueprintPure)
+	float getFlashValue() const { return flashValue; }
+
+	// number of flashes still fading out
+	int32 getNumActiveFlashes() const { return activeFlashes.Num(); }
+
+	// largest flash value overlapping flashes can add up to
+	float getMaxStackedAmount() const { return maxStackedAmount; }
+
+	// most flashes that can fade out at once
+	int32 getMaxActiveFlashes() const { return maxActiveFlashes; }
+
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+protected:
+
+	virtual void BeginPlay() override;
+
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	/** collection the flash post process material reads the flash value from */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly)
+	UMaterialParameterCollection* flashParameters;
+
+	/** name of the flash value in the collection */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly)
+	FName flashParameterName;
+
+	/** how much of a flash is left over its lifetime, time and value both go from 0 to 1 */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly)
+	FRuntimeFloatCurve decayCurve;
+
+	/** seconds a flash takes to fade out */
+	UPROPERTY(config, EditAnywhere, BlueprintReadOnly)
+	float flashDuration;
+
+	/** largest flash value overlapping flashes can add up to, either side of 0 */
+	UPROPERTY(config, EditAnywhere, BlueprintReadOnly)
+	float maxStackedAmount;
+
+	/** most flashes that can fade out at once, the oldest is dropped to make room */
+	UPROPERTY(config, EditAnywhere, BlueprintReadOnly)
+	int32 maxActiveFlashes;
+
+	/** change in the flash value needed before the parameter is written again */
+	UPROPERTY(config, EditAnywhere, BlueprintReadOnly)
+	float parameterChangeThreshold;
+
+	// instance of the collection in this world, found once at begin play
+	UPROPERTY(Transient)
+	UMaterialParameterCollectionInstance* flashParametersInstance;
+
+	// flashes still fading out
+	TArray<FActiveFlash, TInlineAllocator<4>> activeFlashes;
+
+	// flash value last worked out, and last written to the collection
+	float flashValue;
+	float lastPushedValue;
+
+	// writes the flash value to the collection if it has changed enough since it was last written
+	void PushFlashValue(float value);
+};
@@ -0,0 +1,348 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "FlashExposureKernel.h"
+#include "CourseworkCodeCharacter.h"
+#include "CourseworkCodeTestWorld.h"
+#include "Camera/CameraComponent.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformTime.h"
+#include "Math/RandomStream.h"
+#include "Math/VectorRegister.h"
+#include "Misc/AutomationTest.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogFlashExposureKernel, Log, All);
+
+//////////////////////////////////////////////////////////////////////////
+// FFlashListenerSoA
+
+int32 FFlashListenerSoA::Add(const FVector& cameraLocation, const FVector& cameraForward)
+{
+	camX.Add(cameraLocation.X);
+	camY.Add(cameraLocation.Y);
+	camZ.Add(cameraLocation.Z);
+
+	fwdX.Add(cameraForward.X);
+	fwdY.Add(cameraForward.Y);
+	fwdZ.Add(cameraForward.Z);
+
+	return intensity.Add(0.0f);
+}
+
+void FFlashListenerSoA::Reset()
+{
+	camX.Reset();
+	camY.Reset();
+	camZ.Reset();
+	fwdX.Reset();
+	fwdY.Reset();
+	fwdZ.Reset();
+	intensity.Reset();
+}
+
+//////////////////////////////////////////////////////////////////////////
+// FlashExposureKernel
+
+float FlashExposureKernel::GetDistanceFalloff(float distance)
+{
+	return (distance - FalloffRangeMin) / (FalloffRangeMax - FalloffRangeMin) * FalloffScale;
+}
+
+// the listener faces the flash if the flash is less than 90 degrees of yaw either side of the camera
+// which is the same as the flat forward vector and the flat direction to the flash pointing the same way
+void FlashExposureKernel::EvaluateScalar(FFlashListenerSoA& listeners, const FVector& flashLocation, int32 startIndex, int32 count)
+{
+	const int32 endIndex = startIndex + count;
+
+	for (int32 i = startIndex; i < endIndex; i++)
+	{
+		const float toFlashX = flashLocation.X - listeners.camX[i];
+		const float toFlashY = flashLocation.Y - listeners.camY[i];
+		const float toFlashZ = flashLocation.Z - listeners.camZ[i];
+
+		const float distance = FMath::Sqrt(toFlashX * toFlashX + toFlashY * toFlashY + toFlashZ * toFlashZ);
+
+		if (distance >= FlashRange)
+		{
+			listeners.intensity[i] = 0.0f;
+			continue;
+		}
+
+		const float facingDot = listeners.fwdX[i] * toFlashX + listeners.fwdY[i] * toFlashY;
+
+		listeners.intensity[i] = GetDistanceFalloff(distance) * (facingDot > 0.0f ? 1.0f : FacingAwayScale);
+	}
+}
+
+// same maths as the scalar path, but four listeners are loaded into each vector register
+void FlashExposureKernel::EvaluateVectorized(FFlashListenerSoA& listeners, const FVector& flashLocation, int32 startIndex, int32 count)
+{
+	const VectorRegister flashX = VectorSetFloat1(flashLocation.X);
+	const VectorRegister flashY = VectorSetFloat1(flashLocation.Y);
+	const VectorRegister flashZ = VectorSetFloat1(flashLocation.Z);
+
+	// the falloff is folded into one multiply-add of the distance
+	const float falloffSlope = FalloffScale / (FalloffRangeMax - FalloffRangeMin);
+	const VectorRegister falloffSlopeReg = VectorSetFloat1(falloffSlope);
+	const VectorRegister falloffOffsetReg = VectorSetFloat1(-FalloffRangeMin * falloffSlope);
+
+	const VectorRegister flashRangeReg = VectorSetFloat1(FlashRange);
+	const VectorRegister facingAwayReg = VectorSetFloat1(FacingAwayScale);
+	const VectorRegister minDistanceSquaredReg = VectorSetFloat1(SMALL_NUMBER);
+
+	const int32 endIndex = startIndex + count;
+	const int32 vectorEndIndex = startIndex + (count & ~3);
+
+	const float* RESTRICT camX = listeners.camX.GetData();
+	const float* RESTRICT camY = listeners.camY.GetData();
+	const float* RESTRICT camZ = listeners.camZ.GetData();
+	const float* RESTRICT fwdX = listeners.fwdX.GetData();
+	const float* RESTRICT fwdY = listeners.fwdY.GetData();
+	float* RESTRICT intensity = listeners.intensity.GetData();
+
+	for (int32 i = startIndex; i < vectorEndIndex; i += 4)
+	{
+		const VectorRegister toFlashX = VectorSubtract(flashX, VectorLoad(camX + i));
+		const VectorRegister toFlashY = VectorSubtract(flashY, VectorLoad(camY + i));
+		const VectorRegister toFlashZ = VectorSubtract(flashZ, VectorLoad(camZ + i));
+
+		// distance as distance squared over its square root, kept away from 0 so the reciprocal stays finite
+		VectorRegister distanceSquared = VectorMultiply(toFlashX, toFlashX);
+		distanceSquared = VectorMultiplyAdd(toFlashY, toFlashY, distanceSquared);
+		distanceSquared = VectorMultiplyAdd(toFlashZ, toFlashZ, distanceSquared);
+		distanceSquared = VectorMax(distanceSquared, minDistanceSquaredReg);
+
+		const VectorRegister distance = VectorMultiply(distanceSquared, VectorReciprocalSqrtAccurate(distanceSquared));
+
+		const VectorRegister falloff = VectorMultiplyAdd(distance, falloffSlopeReg, falloffOffsetReg);
+
+		// only the sign of the flat dot product is needed, so neither vector has to be normalized
+		const VectorRegister facingDot = VectorMultiplyAdd(VectorLoad(fwdY + i), toFlashY, VectorMultiply(VectorLoad(fwdX + i), toFlashX));
+		const VectorRegister facingScale = VectorSelect(VectorCompareGT(facingDot, GlobalVectorConstants::FloatZero), GlobalVectorConstants::FloatOne, facingAwayReg);
+
+		const VectorRegister inRange = VectorCompareGT(flashRangeReg, distance);
+
+		VectorStore(VectorSelect(inRange, VectorMultiply(falloff, facingScale), GlobalVectorConstants::FloatZero), intensity + i);
+	}
+
+	// finish any listeners that didn't fill a full register
+	if (vectorEndIndex < endIndex)
+	{
+		EvaluateScalar(listeners, flashLocation, vectorEndIndex, endIndex - vectorEndIndex);
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Benchmark
+
+#if !UE_BUILD_SHIPPING
+
+namespace FlashExposureBenchmark
+{
+	// listeners scattered around the flash, some out of range, looking in random directions
+	static void FillListeners(FFlashListenerSoA& listeners, int32 numListeners, FRandomStream& random)
+	{
+		listeners.Reset();
+
+		for (int32 i = 0; i < numListeners; i++)
+		{
+			const FVector cameraLocation = random.GetUnitVector() * random.FRandRange(0.0f, 2500.0f);
+			const FRotator cameraRotation(random.FRandRange(-80.0f, 80.0f), random.FRandRange(-180.0f, 180.0f), 0.0f);
+
+			listeners.Add(cameraLocation, cameraRotation.Vector());
+		}
+	}
+
+	// times one kernel over a number of flashes and returns the average milliseconds per flash
+	template<typename KernelFunc>
+	static double TimeKernel(FFlashListenerSoA& listeners, int32 numFlashes, KernelFunc kernel)
+	{
+		const double startTime = FPlatformTime::Seconds();
+
+		for (int32 flash = 0; flash < numFlashes; flash++)
+		{
+			kernel(listeners, FVector(flash * 0.1f, 0.0f, 0.0f), 0, listeners.Num());
+		}
+
+		return (FPlatformTime::Seconds() - startTime) * 1000.0 / numFlashes;
+	}
+
+	// runs the scalar and vectorized kernels on the same listeners and logs the timings
+	static void Run(const TArray<FString>& args)
+	{
+		TArray<int32> listenerCounts;
+		int32 numFlashes = 1000;
+
+		// arguments are listener counts, with an optional flashes= value
+		for (const FString& arg : args)
+		{
+			if (arg.StartsWith(TEXT("flashes=")))
+			{
+				numFlashes = FMath::Max(1, FCString::Atoi(*arg.RightChop(8)));
+			}
+
+			else if (arg.IsNumeric())
+			{
+				listenerCounts.Add(FMath::Max(1, FCString::Atoi(*arg)));
+			}
+		}
+
+		if (listenerCounts.Num() == 0)
+		{
+			listenerCounts = { 64, 1024, 16384 };
+		}
+
+		UE_LOG(LogFlashExposureKernel, Display, TEXT("Flash exposure kernel benchmark: %d flashes"), numFlashes);
+
+		for (int32 numListeners : listenerCounts)
+		{
+			FRandomStream random(1234);
+			FFlashListenerSoA listeners;
+			FillListeners(listeners, numListeners, random);
+
+			const double scalarMs = TimeKernel(listeners, numFlashes, &FlashExposureKernel::EvaluateScalar);
+			const double vectorMs = TimeKernel(listeners, numFlashes, &FlashExposureKernel::EvaluateVectorized);
+
+			UE_LOG(LogFlashExposureKernel, Display, TEXT("%6d listeners: scalar %.5f ms, vectorized %.5f ms (%.2fx)"),
+				numListeners, scalarMs, vectorMs, vectorMs > 0.0 ? scalarMs / vectorMs : 0.0);
+		}
+	}
+
+	static FAutoConsoleCommand BenchmarkCommand(
+		TEXT("FlashExposure.Benchmark"),
+		TEXT("Compares the scalar and vectorized flash exposure kernels. Usage: FlashExposure.Benchmark [listener counts...] [flashes=1000]"),
+		FConsoleCommandWithArgsDelegate::CreateStatic(&Run));
+}
+
+#endif
+
+//////////////////////////////////////////////////////////////////////////
+// Tests
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFlashExposureKernelTest, "CourseworkCode.FlashExposure.KernelsMatchCharacter", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFlashExposureWrapTest, "CourseworkCode.FlashExposure.FacingAcrossYawWrap", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+namespace FlashExposureTests
+{
+	// flash amount from the character's own range check, before the facing check
+	static float GetCharacterFlashAmount(ACourseworkCodeCharacter* character, const FVector& cameraLocation, const FVector& flashLocation, bool& outOfRange)
+	{
+		FVector facingOutput;
+		outOfRange = character->ifInFlashbangRange(FVector::Dist(cameraLocation, flashLocation), flashLocation, facingOutput);
+
+		return character->getFlashAmount();
+	}
+
+	// points the character's camera and asks the character how much it is flashed, a half flash is half the amount
+	static float GetCharacterIntensity(ACourseworkCodeCharacter* character, const FVector& cameraLocation, const FRotator& cameraRotation, const FVector& flashLocation)
+	{
+		character->GetFirstPersonCameraComponent()->SetWorldLocationAndRotation(cameraLocation, cameraRotation);
+
+		bool outOfRange;
+		const float flashAmount = GetCharacterFlashAmount(character, cameraLocation, flashLocation, outOfRange);
+
+		if (outOfRange)
+		{
+			return 0.0f;
+		}
+
+		return character->AngleFromFlash(flashLocation) ? flashAmount * 0.5f : flashAmount;
+	}
+}
+
+// the character's AngleFromFlash doesn't wrap the yaw difference, so every listener here keeps both yaws within 90 degrees of 0
+// and the difference never crosses +-180, listeners within half a degree of the edge of the cone are left out
+bool FFlashExposureKernelTest::RunTest(const FString& Parameters)
+{
+	// play isn't started so the character never ticks
+	FCourseworkCodeTestWorld testWorld;
+	ACourseworkCodeCharacter* character = testWorld.SpawnActor<ACourseworkCodeCharacter>(FTransform::Identity);
+	const UCameraComponent* camera = character->GetFirstPersonCameraComponent();
+
+	const FVector flashLocation(300.0f, -200.0f, 50.0f);
+
+	// an odd number so the vectorized kernel has listeners left over for the scalar path
+	const int32 numListeners = 4099;
+
+	FRandomStream random(4321);
+	FFlashListenerSoA scalarListeners;
+	TArray<float> expectedIntensity;
+
+	while (scalarListeners.Num() < numListeners)
+	{
+		const float cameraYaw = random.FRandRange(-90.0f, 90.0f);
+		const float toFlashYaw = random.FRandRange(-90.0f, 90.0f);
+
+		if (FMath::Abs(FMath::Abs(toFlashYaw - cameraYaw) - 90.0f) < 0.5f)
+		{
+			continue;
+		}
+
+		const FVector toFlash = FRotator(random.FRandRange(-60.0f, 60.0f), toFlashYaw, 0.0f).Vector();
+		const FVector cameraLocation = flashLocation - toFlash * random.FRandRange(1.0f, 2500.0f);
+		const FRotator cameraRotation(random.FRandRange(-80.0f, 80.0f), cameraYaw, 0.0f);
+
+		expectedIntensity.Add(FlashExposureTests::GetCharacterIntensity(character, cameraLocation, cameraRotation, flashLocation));
+		scalarListeners.Add(camera->GetComponentLocation(), camera->GetForwardVector());
+	}
+
+	FFlashListenerSoA vectorListeners = scalarListeners;
+
+	FlashExposureKernel::EvaluateScalar(scalarListeners, flashLocation, 0, scalarListeners.Num());
+	FlashExposureKernel::EvaluateVectorized(vectorListeners, flashLocation, 0, vectorListeners.Num());
+
+	float maxScalarError = 0.0f;
+	float maxVectorError = 0.0f;
+
+	for (int32 i = 0; i < numListeners; i++)
+	{
+		maxScalarError = FMath::Max(maxScalarError, FMath::Abs(scalarListeners.intensity[i] - expectedIntensity[i]));
+		maxVectorError = FMath::Max(maxVectorError, FMath::Abs(vectorListeners.intensity[i] - expectedIntensity[i]));
+	}
+
+	TestTrue(FString::Printf(TEXT("Scalar kernel matches the character within 0.001 (%.6f)"), maxScalarError), maxScalarError < 0.001f);
+	TestTrue(FString::Printf(TEXT("Vectorized kernel matches the character within 0.001 (%.6f)"), maxVectorError), maxVectorError < 0.001f);
+
+	return true;
+}
+
+// listeners looking almost straight at a flash just across the +-180 degree yaw wrap are fully flashed by the kernels
+// the character's unwrapped AngleFromFlash gives these a half flash, so only its range check is compared
+bool FFlashExposureWrapTest::RunTest(const FString& Parameters)
+{
+	FCourseworkCodeTestWorld testWorld;
+	ACourseworkCodeCharacter* character = testWorld.SpawnActor<ACourseworkCodeCharacter>(FTransform::Identity);
+
+	const FVector cameraLocation(0.0f, 0.0f, 0.0f);
+
+	FFlashListenerSoA listeners;
+	TArray<FVector> flashLocations;
+
+	for (float cameraYaw : { 179.0f, -179.0f })
+	{
+		listeners.Add(cameraLocation, FRotator(0.0f, cameraYaw, 0.0f).Vector());
+		flashLocations.Add(cameraLocation + FRotator(0.0f, -cameraYaw, 0.0f).Vector() * 500.0f);
+	}
+
+	for (int32 i = 0; i < listeners.Num(); i++)
+	{
+		bool outOfRange;
+		const float flashAmount = FlashExposureTests::GetCharacterFlashAmount(character, cameraLocation, flashLocations[i], outOfRange);
+
+		FFlashListenerSoA vectorListeners = listeners;
+		FlashExposureKernel::EvaluateScalar(listeners, flashLocations[i], i, 1);
+		FlashExposureKernel::EvaluateVectorized(vectorListeners, flashLocations[i], i, 1);
+
+		TestFalse(TEXT("Listener is in range of the flash"), outOfRange);
+		TestEqual(FString::Printf(TEXT("Scalar kernel fully flashes listener %d across the wrap"), i), listeners.intensity[i], flashAmount, 0.001f);
+		TestEqual(FString::Printf(TEXT("Vectorized kernel fully flashes listener %d across the wrap"), i), vectorListeners.intensity[i], flashAmount, 0.001f);
+	}
+
+	return true;
+}
+
+#endif
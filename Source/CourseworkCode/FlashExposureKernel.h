@@ -0,0 +1,65 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Flash listeners stored as a structure of arrays
+ * every array has one entry per listener so the exposure kernel can load four listeners into one vector register
+ */
+struct COURSEWORKCODE_API FFlashListenerSoA
+{
+	// camera position
+	TArray<float> camX;
+	TArray<float> camY;
+	TArray<float> camZ;
+
+	// camera forward vector, doesn't need to be normalized
+	TArray<float> fwdX;
+	TArray<float> fwdY;
+	TArray<float> fwdZ;
+
+	// flash intensity written by the kernel, 0 for listeners out of range
+	TArray<float> intensity;
+
+	int32 Num() const { return camX.Num(); }
+
+	// adds a listener to the end of every array and returns its index
+	int32 Add(const FVector& cameraLocation, const FVector& cameraForward);
+
+	void Reset();
+
+	FVector GetCameraLocation(int32 index) const { return FVector(camX[index], camY[index], camZ[index]); }
+	FVector GetCameraForward(int32 index) const { return FVector(fwdX[index], fwdY[index], fwdZ[index]); }
+};
+
+/**
+ * Flash exposure kernels for Curveball flashes
+ * uses the same distance falloff and range as ACourseworkCodeCharacter::ifInFlashbangRange
+ * and the same 90 degree yaw cone as ACourseworkCodeCharacter::AngleFromFlash, tested with a dot product so it works across the +-180 degree wrap
+ * listeners facing away from the flash get half the intensity
+ */
+namespace FlashExposureKernel
+{
+	// distance beyond which listeners are never flashed
+	static const float FlashRange = 2000.0f;
+
+	// distance range the falloff is normalized to, and the scale applied afterwards
+	static const float FalloffRangeMin = 20.0f;
+	static const float FalloffRangeMax = 100.0f;
+	static const float FalloffScale = -0.1f;
+
+	// intensity multiplier for listeners facing away from the flash
+	static const float FacingAwayScale = 0.5f;
+
+	// distance falloff of the flash, the same value ifInFlashbangRange stores as the flash amount
+	COURSEWORKCODE_API float GetDistanceFalloff(float distance);
+
+	// works out the intensity of listeners [startIndex, startIndex + count) one listener at a time
+	COURSEWORKCODE_API void EvaluateScalar(FFlashListenerSoA& listeners, const FVector& flashLocation, int32 startIndex, int32 count);
+
+	// works out the intensity of listeners [startIndex, startIndex + count) four at a time using vector registers
+	// any listeners left over after the last group of four use the scalar path
+	COURSEWORKCODE_API void EvaluateVectorized(FFlashListenerSoA& listeners, const FVector& flashLocation, int32 startIndex, int32 count);
+}
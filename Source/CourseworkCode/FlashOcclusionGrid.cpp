@@ -0,0 +1,646 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "FlashOcclusionGrid.h"
+#include "CourseworkCode.h"
+#include "CourseworkCodeTestWorld.h"
+#include "Components/BoxComponent.h"
+#include "Components/PrimitiveComponent.h"
+#include "Engine/CollisionProfile.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformFilemanager.h"
+#include "HAL/PlatformTime.h"
+#include "Math/RandomStream.h"
+#include "Misc/AutomationTest.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+DECLARE_CYCLE_STAT(TEXT("Flash Occlusion Grid Walk"), STAT_FlashOcclusionWalk, STATGROUP_CourseworkCode);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Flash Occlusion Grid Visible"), STAT_FlashOcclusionVisible, STATGROUP_CourseworkCode);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Flash Occlusion Grid Blocked"), STAT_FlashOcclusionBlocked, STATGROUP_CourseworkCode);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Flash Occlusion Grid Unknown"), STAT_FlashOcclusionUnknown, STATGROUP_CourseworkCode);
+
+DEFINE_LOG_CATEGORY_STATIC(LogFlashOcclusion, Log, All);
+
+// "FOGR", bump the version whenever the header or voxel layout changes so old files are baked again
+static const uint32 FlashOcclusionGridMagic = 0x52474F46;
+static const uint32 FlashOcclusionGridVersion = 2;
+
+// sets default grid settings, these can be overridden in DefaultGame.ini
+UFlashOcclusionGrid::UFlashOcclusionGrid()
+{
+	useBakedGrid = true;
+	bakeIfMissing = true;
+	voxelSize = 50.0f;
+	maxVoxels = 16 * 1024 * 1024;
+
+	FMemory::Memzero(header);
+	voxelBits = NULL;
+	hasTriedLoad = false;
+}
+
+void UFlashOcclusionGrid::Deinitialize()
+{
+	ReleaseGrid();
+
+	Super::Deinitialize();
+}
+
+EFlashOcclusion UFlashOcclusionGrid::QueryLineOfSight(const FVector& start, const FVector& end)
+{
+	if (!useBakedGrid)
+	{
+		return EFlashOcclusion::Unknown;
+	}
+
+	// normally already done when play started
+	PrepareGrid();
+
+	if (voxelBits == NULL)
+	{
+		INC_DWORD_STAT(STAT_FlashOcclusionUnknown);
+		return EFlashOcclusion::Unknown;
+	}
+
+	// a solid voxel at either end can't say whether the geometry is between the points or just next to one of them
+	if (IsVoxelSolid(GetVoxelCoord(start)) || IsVoxelSolid(GetVoxelCoord(end)))
+	{
+		INC_DWORD_STAT(STAT_FlashOcclusionUnknown);
+		return EFlashOcclusion::Unknown;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_FlashOcclusionWalk);
+
+	if (WalkGrid(start, end))
+	{
+		INC_DWORD_STAT(STAT_FlashOcclusionBlocked);
+		return EFlashOcclusion::Blocked;
+	}
+
+	INC_DWORD_STAT(STAT_FlashOcclusionVisible);
+	return EFlashOcclusion::Visible;
+}
+
+// the grid is only looked for once per map, baking causes a hitch so it is only done here if asked for
+void UFlashOcclusionGrid::PrepareGrid()
+{
+	if (!useBakedGrid || hasTriedLoad)
+	{
+		return;
+	}
+
+	if (!LoadGrid() && bakeIfMissing)
+	{
+		BakeAndSave();
+	}
+
+	hasTriedLoad = true;
+}
+
+bool UFlashOcclusionGrid::BakeAndSave()
+{
+	TArray<uint8> fileData;
+	if (!BakeGridData(fileData))
+	{
+		return false;
+	}
+
+	// the old grid has to be unmapped before its file can be written over
+	ReleaseGrid();
+
+	// a packaged build may not be able to write to its content folder, so the grid is kept in memory for this session instead
+	const FString filename = GetGridFilename();
+	if (!FFileHelper::SaveArrayToFile(fileData, *filename))
+	{
+		UE_LOG(LogFlashOcclusion, Warning, TEXT("Couldn't save flash occlusion grid to %s, it will only be used until the map is unloaded"), *filename);
+
+		loadedData = MoveTemp(fileData);
+		hasTriedLoad = true;
+		return SetGridData(loadedData.GetData(), loadedData.Num());
+	}
+
+	return LoadGrid();
+}
+
+bool UFlashOcclusionGrid::BakeInMemory()
+{
+	TArray<uint8> fileData;
+	if (!BakeGridData(fileData))
+	{
+		return false;
+	}
+
+	ReleaseGrid();
+
+	loadedData = MoveTemp(fileData);
+	hasTriedLoad = true;
+	return SetGridData(loadedData.GetData(), loadedData.Num());
+}
+
+// each voxel is an overlap query against static geometry, so this is only meant to run once per map
+// the whole voxel is tested, so any voxel touched by geometry is solid and thin walls are never missed
+bool UFlashOcclusionGrid::BakeGridData(TArray<uint8>& outFileData)
+{
+	UWorld* const World = GetWorld();
+	if (World == NULL)
+	{
+		return false;
+	}
+
+	const FBox staticBounds = GetStaticGeometryBounds();
+	if (!staticBounds.IsValid)
+	{
+		UE_LOG(LogFlashOcclusion, Warning, TEXT("No static geometry with collision to bake in %s"), *World->GetMapName());
+		return false;
+	}
+
+	// a voxel of padding keeps geometry on the edge of the level inside the grid
+	const FBox bounds = staticBounds.ExpandBy(voxelSize);
+	const FVector boundsSize = bounds.GetSize();
+
+	FFlashOcclusionGridHeader newHeader;
+	newHeader.magic = FlashOcclusionGridMagic;
+	newHeader.version = FlashOcclusionGridVersion;
+	newHeader.voxelSize = voxelSize;
+	newHeader.originX = bounds.Min.X;
+	newHeader.originY = bounds.Min.Y;
+	newHeader.originZ = bounds.Min.Z;
+	newHeader.sizeX = FMath::Max(1, FMath::CeilToInt(boundsSize.X / voxelSize));
+	newHeader.sizeY = FMath::Max(1, FMath::CeilToInt(boundsSize.Y / voxelSize));
+	newHeader.sizeZ = FMath::Max(1, FMath::CeilToInt(boundsSize.Z / voxelSize));
+
+	const int64 numVoxels = (int64)newHeader.sizeX * newHeader.sizeY * newHeader.sizeZ;
+	if (numVoxels > maxVoxels)
+	{
+		UE_LOG(LogFlashOcclusion, Warning, TEXT("Flash occlusion grid for %s would need %lld voxels, more than the limit of %d, use a bigger voxel size"),
+			*World->GetMapName(), numVoxels, maxVoxels);
+		return false;
+	}
+
+	const double startTime = FPlatformTime::Seconds();
+
+	outFileData.Reset();
+	outFileData.SetNumZeroed(sizeof(FFlashOcclusionGridHeader) + (numVoxels + 7) / 8);
+	FMemory::Memcpy(outFileData.GetData(), &newHeader, sizeof(FFlashOcclusionGridHeader));
+
+	uint8* bits = outFileData.GetData() + sizeof(FFlashOcclusionGridHeader);
+
+	const FCollisionShape voxelShape = FCollisionShape::MakeBox(FVector(voxelSize * 0.5f));
+	const FCollisionObjectQueryParams objectParams(ECC_WorldStatic);
+	FCollisionQueryParams overlapParams(SCENE_QUERY_STAT(FlashOcclusionBake), false);
+
+	TArray<FOverlapResult> voxelOverlaps;
+	int64 numSolid = 0;
+
+	for (int32 z = 0; z < newHeader.sizeZ; z++)
+	{
+		for (int32 y = 0; y < newHeader.sizeY; y++)
+		{
+			for (int32 x = 0; x < newHeader.sizeX; x++)
+			{
+				const FVector voxelCentre = bounds.Min + (FVector(x, y, z) + 0.5f) * voxelSize;
+
+				voxelOverlaps.Reset();
+				World->OverlapMultiByObjectType(voxelOverlaps, voxelCentre, FQuat::Identity, objectParams, voxelShape, overlapParams);
+
+				// anything that can move is left to the traces
+				for (const FOverlapResult& overlap : voxelOverlaps)
+				{
+					const UPrimitiveComponent* component = overlap.GetComponent();
+					if (component != NULL && component->Mobility == EComponentMobility::Static)
+					{
+						const int64 index = ((int64)z * newHeader.sizeY + y) * newHeader.sizeX + x;
+						bits[index >> 3] |= 1 << (index & 7);
+						numSolid++;
+						break;
+					}
+				}
+			}
+		}
+	}
+
+	UE_LOG(LogFlashOcclusion, Display, TEXT("Baked flash occlusion grid for %s: %d x %d x %d voxels of %.0f, %lld solid, %d KB, %.1f ms"),
+		*World->GetMapName(), newHeader.sizeX, newHeader.sizeY, newHeader.sizeZ, voxelSize, numSolid, outFileData.Num() / 1024,
+		(FPlatformTime::Seconds() - startTime) * 1000.0);
+
+	return true;
+}
+
+// the file is mapped rather than read so only the pages a flash walks through are ever loaded
+bool UFlashOcclusionGrid::LoadGrid()
+{
+	ReleaseGrid();
+	hasTriedLoad = true;
+
+	const FString filename = GetGridFilename();
+
+	IPlatformFile& platformFile = FPlatformFileManager::Get().GetPlatformFile();
+	if (!platformFile.FileExists(*filename))
+	{
+		return false;
+	}
+
+	mappedFile.Reset(platformFile.OpenMapped(*filename));
+	if (mappedFile.IsValid())
+	{
+		mappedRegion.Reset(mappedFile->MapRegion(0, mappedFile->GetFileSize()));
+	}
+
+	bool isLoaded = false;
+	if (mappedRegion.IsValid())
+	{
+		isLoaded = SetGridData(mappedRegion->GetMappedPtr(), mappedRegion->GetMappedSize());
+	}
+
+	else if (FFileHelper::LoadFileToArray(loadedData, *filename))
+	{
+		isLoaded = SetGridData(loadedData.GetData(), loadedData.Num());
+	}
+
+	if (!isLoaded)
+	{
+		UE_LOG(LogFlashOcclusion, Warning, TEXT("%s isn't a valid flash occlusion grid, it needs baking again"), *filename);
+
+		ReleaseGrid();
+		hasTriedLoad = true;
+		return false;
+	}
+
+	UE_LOG(LogFlashOcclusion, Log, TEXT("Loaded flash occlusion grid %s (%d x %d x %d voxels, %s)"),
+		*filename, header.sizeX, header.sizeY, header.sizeZ, mappedRegion.IsValid() ? TEXT("mapped") : TEXT("read"));
+
+	return true;
+}
+
+void UFlashOcclusionGrid::ReleaseGrid()
+{
+	voxelBits = NULL;
+	FMemory::Memzero(header);
+
+	mappedRegion.Reset();
+	mappedFile.Reset();
+	loadedData.Empty();
+
+	hasTriedLoad = false;
+}
+
+FBox UFlashOcclusionGrid::getGridBounds() const
+{
+	if (voxelBits == NULL)
+	{
+		return FBox(ForceInit);
+	}
+
+	const FVector origin(header.originX, header.originY, header.originZ);
+
+	return FBox(origin, origin + FVector(header.sizeX, header.sizeY, header.sizeZ) * header.voxelSize);
+}
+
+// one file per map, PIE worlds share the file of the map they were started from
+// the folder is staged as loose files when packaging, so shipped builds can map the grid baked in the editor
+FString UFlashOcclusionGrid::GetGridFilename() const
+{
+	const UWorld* const World = GetWorld();
+	const FString mapName = World != NULL ? UWorld::RemovePIEPrefix(World->GetMapName()) : FString(TEXT("None"));
+
+	return FPaths::ProjectContentDir() / TEXT("FlashOcclusion") / mapName + TEXT(".flashgrid");
+}
+
+bool UFlashOcclusionGrid::SetGridData(const uint8* data, int64 dataSize)
+{
+	if (data == NULL || dataSize < (int64)sizeof(FFlashOcclusionGridHeader))
+	{
+		return false;
+	}
+
+	FFlashOcclusionGridHeader newHeader;
+	FMemory::Memcpy(&newHeader, data, sizeof(FFlashOcclusionGridHeader));
+
+	if (newHeader.magic != FlashOcclusionGridMagic || newHeader.version != FlashOcclusionGridVersion || newHeader.voxelSize <= 0.0f
+		|| newHeader.sizeX <= 0 || newHeader.sizeY <= 0 || newHeader.sizeZ <= 0)
+	{
+		return false;
+	}
+
+	const int64 numVoxels = (int64)newHeader.sizeX * newHeader.sizeY * newHeader.sizeZ;
+	if (dataSize < (int64)sizeof(FFlashOcclusionGridHeader) + (numVoxels + 7) / 8)
+	{
+		return false;
+	}
+
+	header = newHeader;
+	voxelBits = data + sizeof(FFlashOcclusionGridHeader);
+
+	return true;
+}
+
+FIntVector UFlashOcclusionGrid::GetVoxelCoord(const FVector& location) const
+{
+	const FVector gridLocation = (location - FVector(header.originX, header.originY, header.originZ)) / header.voxelSize;
+
+	return FIntVector(FMath::FloorToInt(gridLocation.X), FMath::FloorToInt(gridLocation.Y), FMath::FloorToInt(gridLocation.Z));
+}
+
+bool UFlashOcclusionGrid::IsVoxelSolid(const FIntVector& voxel) const
+{
+	if (voxelBits == NULL || voxel.X < 0 || voxel.Y < 0 || voxel.Z < 0 || voxel.X >= header.sizeX || voxel.Y >= header.sizeY || voxel.Z >= header.sizeZ)
+	{
+		return false;
+	}
+
+	const int64 index = ((int64)voxel.Z * header.sizeY + voxel.Y) * header.sizeX + voxel.X;
+
+	return (voxelBits[index >> 3] & (1 << (index & 7))) != 0;
+}
+
+// Amanatides and Woo voxel traversal, each step moves into whichever neighbouring voxel the line reaches first
+bool UFlashOcclusionGrid::WalkGrid(const FVector& start, const FVector& end) const
+{
+	const FVector origin(header.originX, header.originY, header.originZ);
+	const FVector gridSize(header.sizeX, header.sizeY, header.sizeZ);
+
+	// worked out in voxel units so every voxel is 1 along each side
+	const FVector from = (start - origin) / header.voxelSize;
+	const FVector to = (end - origin) / header.voxelSize;
+	const FVector direction = to - from;
+
+	// clip the line to the grid, the grid covers all static geometry so nothing outside it blocks
+	float entryTime = 0.0f;
+	float exitTime = 1.0f;
+
+	for (int32 axis = 0; axis < 3; axis++)
+	{
+		if (FMath::IsNearlyZero(direction[axis]))
+		{
+			if (from[axis] < 0.0f || from[axis] > gridSize[axis])
+			{
+				return false;
+			}
+
+			continue;
+		}
+
+		float axisEntry = -from[axis] / direction[axis];
+		float axisExit = (gridSize[axis] - from[axis]) / direction[axis];
+		if (axisEntry > axisExit)
+		{
+			Swap(axisEntry, axisExit);
+		}
+
+		entryTime = FMath::Max(entryTime, axisEntry);
+		exitTime = FMath::Min(exitTime, axisExit);
+
+		if (entryTime > exitTime)
+		{
+			return false;
+		}
+	}
+
+	const FVector entry = from + direction * entryTime;
+	const FVector exit = from + direction * exitTime;
+
+	FIntVector voxel(
+		FMath::Clamp(FMath::FloorToInt(entry.X), 0, header.sizeX - 1),
+		FMath::Clamp(FMath::FloorToInt(entry.Y), 0, header.sizeY - 1),
+		FMath::Clamp(FMath::FloorToInt(entry.Z), 0, header.sizeZ - 1));
+
+	const FIntVector lastVoxel(
+		FMath::Clamp(FMath::FloorToInt(exit.X), 0, header.sizeX - 1),
+		FMath::Clamp(FMath::FloorToInt(exit.Y), 0, header.sizeY - 1),
+		FMath::Clamp(FMath::FloorToInt(exit.Z), 0, header.sizeZ - 1));
+
+	// time along the line of the next voxel boundary on each axis, and the time between boundaries
+	FIntVector step;
+	FVector nextTime;
+	FVector deltaTime;
+
+	for (int32 axis = 0; axis < 3; axis++)
+	{
+		if (FMath::IsNearlyZero(direction[axis]))
+		{
+			step[axis] = 0;
+			nextTime[axis] = BIG_NUMBER;
+			deltaTime[axis] = BIG_NUMBER;
+		}
+
+		else if (direction[axis] > 0.0f)
+		{
+			step[axis] = 1;
+			nextTime[axis] = (voxel[axis] + 1 - from[axis]) / direction[axis];
+			deltaTime[axis] = 1.0f / direction[axis];
+		}
+
+		else
+		{
+			step[axis] = -1;
+			nextTime[axis] = (voxel[axis] - from[axis]) / direction[axis];
+			deltaTime[axis] = -1.0f / direction[axis];
+		}
+	}
+
+	const int32 maxSteps = header.sizeX + header.sizeY + header.sizeZ;
+
+	for (int32 i = 0; i <= maxSteps; i++)
+	{
+		if (IsVoxelSolid(voxel))
+		{
+			return true;
+		}
+
+		if (voxel == lastVoxel)
+		{
+			break;
+		}
+
+		const int32 axis = nextTime.X < nextTime.Y ? (nextTime.X < nextTime.Z ? 0 : 2) : (nextTime.Y < nextTime.Z ? 1 : 2);
+		if (nextTime[axis] > exitTime)
+		{
+			break;
+		}
+
+		voxel[axis] += step[axis];
+		nextTime[axis] += deltaTime[axis];
+	}
+
+	return false;
+}
+
+// the same components the bake tests against, so the grid is only as big as it needs to be
+FBox UFlashOcclusionGrid::GetStaticGeometryBounds() const
+{
+	FBox bounds(ForceInit);
+
+	UWorld* const World = GetWorld();
+	if (World == NULL)
+	{
+		return bounds;
+	}
+
+	for (TActorIterator<AActor> actorIt(World); actorIt; ++actorIt)
+	{
+		TInlineComponentArray<UPrimitiveComponent*> components(*actorIt);
+
+		for (UPrimitiveComponent* component : components)
+		{
+			if (component->Mobility == EComponentMobility::Static && component->IsCollisionEnabled() && component->GetCollisionObjectType() == ECC_WorldStatic)
+			{
+				bounds += component->Bounds.GetBox();
+			}
+		}
+	}
+
+	return bounds;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Bake
+
+namespace FlashOcclusionBake
+{
+	// bakes the grid for the current map, can be run headless with -ExecCmds
+	static void Run(const TArray<FString>& Args, UWorld* World)
+	{
+		UFlashOcclusionGrid* occlusionGrid = World != NULL ? World->GetSubsystem<UFlashOcclusionGrid>() : NULL;
+		if (occlusionGrid == NULL)
+		{
+			UE_LOG(LogFlashOcclusion, Warning, TEXT("FlashOcclusion.Bake needs a game world"));
+			return;
+		}
+
+		if (!occlusionGrid->BakeAndSave())
+		{
+			UE_LOG(LogFlashOcclusion, Warning, TEXT("FlashOcclusion.Bake failed for %s"), *World->GetMapName());
+		}
+	}
+
+	static FAutoConsoleCommandWithWorldAndArgs BakeCommand(
+		TEXT("FlashOcclusion.Bake"),
+		TEXT("Voxelizes the static geometry of the current map and saves it as the flash occlusion grid. Usage: FlashOcclusion.Bake"),
+		FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&Run));
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Tests
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFlashOcclusionGridTraceMatchTest, "CourseworkCode.FlashOcclusion.GridMatchesTraces", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+namespace FlashOcclusionTests
+{
+	static FVector RandomPointInBox(FRandomStream& random, const FBox& box)
+	{
+		return FVector(random.FRandRange(box.Min.X, box.Max.X), random.FRandRange(box.Min.Y, box.Max.Y), random.FRandRange(box.Min.Z, box.Max.Z));
+	}
+
+	// spawns a static, blocking box, the same kind of geometry the grid bakes
+	static void SpawnStaticBox(const FCourseworkCodeTestWorld& testWorld, const FVector& location, const FRotator& rotation, const FVector& extent)
+	{
+		AActor* boxActor = testWorld.SpawnActor<AActor>(FTransform::Identity);
+
+		// static components can't be moved once registered, so they are placed first
+		UBoxComponent* box = NewObject<UBoxComponent>(boxActor);
+		box->SetMobility(EComponentMobility::Static);
+		box->SetBoxExtent(extent);
+		box->SetCollisionProfileName(UCollisionProfile::BlockAll_ProfileName);
+		box->SetWorldLocationAndRotation(location, rotation);
+		boxActor->SetRootComponent(box);
+		box->RegisterComponent();
+	}
+}
+
+// bakes a small level of floor and thin walls, then checks random lines through it against static geometry traces
+// Unknown lines are traced by the resolver, so they can't be wrong
+// the grid must never let a line through that a trace blocks, and only blocks a few lines a trace lets through
+bool FFlashOcclusionGridTraceMatchTest::RunTest(const FString& Parameters)
+{
+	FCourseworkCodeTestWorld testWorld;
+	UWorld* const World = testWorld.GetWorld();
+
+	FRandomStream random(2468);
+
+	FlashOcclusionTests::SpawnStaticBox(testWorld, FVector(0.0f, 0.0f, -10.0f), FRotator::ZeroRotator, FVector(2000.0f, 2000.0f, 10.0f));
+
+	for (int32 i = 0; i < 16; i++)
+	{
+		const FVector extent(random.FRandRange(100.0f, 400.0f), random.FRandRange(10.0f, 30.0f), random.FRandRange(100.0f, 300.0f));
+		const FVector location(random.FRandRange(-1500.0f, 1500.0f), random.FRandRange(-1500.0f, 1500.0f), extent.Z);
+
+		FlashOcclusionTests::SpawnStaticBox(testWorld, location, FRotator(0.0f, random.FRandRange(0.0f, 180.0f), 0.0f), extent);
+	}
+
+	UFlashOcclusionGrid* occlusionGrid = World->GetSubsystem<UFlashOcclusionGrid>();
+	if (!TestNotNull(TEXT("Flash occlusion grid"), occlusionGrid) || !TestTrue(TEXT("Grid baked"), occlusionGrid->BakeInMemory()))
+	{
+		return false;
+	}
+
+	const int32 numLines = 10000;
+	const FBox gridBounds = occlusionGrid->getGridBounds();
+
+	TArray<FVector> lineStarts;
+	TArray<FVector> lineEnds;
+
+	for (int32 i = 0; i < numLines; i++)
+	{
+		lineStarts.Add(FlashOcclusionTests::RandomPointInBox(random, gridBounds));
+		lineEnds.Add(FlashOcclusionTests::RandomPointInBox(random, gridBounds));
+	}
+
+	TArray<EFlashOcclusion> gridResults;
+	gridResults.SetNum(numLines);
+
+	double startTime = FPlatformTime::Seconds();
+	for (int32 i = 0; i < numLines; i++)
+	{
+		gridResults[i] = occlusionGrid->QueryLineOfSight(lineStarts[i], lineEnds[i]);
+	}
+	const double gridMs = (FPlatformTime::Seconds() - startTime) * 1000.0;
+
+	TArray<bool> traceBlocked;
+	traceBlocked.SetNum(numLines);
+
+	FCollisionQueryParams traceParams(SCENE_QUERY_STAT(FlashOcclusionTest), false);
+
+	startTime = FPlatformTime::Seconds();
+	for (int32 i = 0; i < numLines; i++)
+	{
+		traceBlocked[i] = World->LineTraceTestByObjectType(lineStarts[i], lineEnds[i], FCollisionObjectQueryParams(ECC_WorldStatic), traceParams);
+	}
+	const double traceMs = (FPlatformTime::Seconds() - startTime) * 1000.0;
+
+	// every voxel geometry touches is solid, so lines grazing a surface can be blocked by the grid alone
+	int32 numFalseBlocked = 0;
+	int32 numFalseVisible = 0;
+	int32 numUnknown = 0;
+
+	for (int32 i = 0; i < numLines; i++)
+	{
+		if (gridResults[i] == EFlashOcclusion::Unknown)
+		{
+			numUnknown++;
+		}
+
+		else if (gridResults[i] == EFlashOcclusion::Blocked && !traceBlocked[i])
+		{
+			numFalseBlocked++;
+		}
+
+		else if (gridResults[i] == EFlashOcclusion::Visible && traceBlocked[i])
+		{
+			numFalseVisible++;
+		}
+	}
+
+	AddInfo(FString::Printf(TEXT("%d lines, %d left to traces, %d blocked only by the grid, grid %.3f ms, traces %.3f ms"),
+		numLines, numUnknown, numFalseBlocked, gridMs, traceMs));
+
+	TestEqual(TEXT("Lines the grid clears that a trace blocks"), numFalseVisible, 0);
+	TestTrue(TEXT("At most 5% of lines are blocked only by the grid"), 100.0f * numFalseBlocked / numLines <= 5.0f);
+
+	return true;
+}
+
+#endif
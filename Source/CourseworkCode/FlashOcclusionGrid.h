@@ -0,0 +1,146 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Async/MappedFileHandle.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "FlashOcclusionGrid.generated.h"
+
+/** what the baked grid knows about the line of sight between two points */
+enum class EFlashOcclusion : uint8
+{
+	// no grid is loaded for this map, or a point is inside a solid voxel, the line has to be traced
+	Unknown,
+
+	// no voxel along the line touches static geometry, the line is still traced for anything that isn't baked
+	Visible,
+
+	// a voxel along the line touches static geometry
+	// every voxel geometry touches is solid, so a line passing close to a surface can be Blocked when a trace would pass
+	Blocked
+};
+
+/** header at the start of a baked grid file, followed by one bit per voxel */
+struct FFlashOcclusionGridHeader
+{
+	uint32 magic;
+	uint32 version;
+
+	// size of a voxel along each side
+	float voxelSize;
+
+	// world position of the corner of voxel 0, 0, 0
+	float originX;
+	float originY;
+	float originZ;
+
+	// number of voxels along each axis
+	int32 sizeX;
+	int32 sizeY;
+	int32 sizeZ;
+};
+
+/**
+ * World subsystem that answers flash line of sight checks from a voxel grid of the level's static geometry
+ * the grid is baked once per map and saved under Content/FlashOcclusion, then memory mapped when the map is played
+ * a map with no saved grid is baked when play starts, and kept in memory if the build can't save it
+ * so a check is a walk through the voxels along the line instead of a physics query
+ * only geometry with static mobility is baked, anything that moves or is spawned, such as Sage Walls, still has to be traced
+ */
+UCLASS(config=Game)
+class COURSEWORKCODE_API UFlashOcclusionGrid : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	UFlashOcclusionGrid();
+
+	virtual void Deinitialize() override;
+
+	// checks the line against the baked grid, loading it the first time
+	// every voxel geometry touches is solid, so a line near a surface can be Blocked when a trace would pass
+	// if the start or end is in a solid voxel the grid can't tell, and the result is Unknown
+	EFlashOcclusion QueryLineOfSight(const FVector& start, const FVector& end);
+
+	// loads the grid for this map, or bakes it if there isn't one and baking is allowed
+	// called when play starts so the first flash doesn't wait on the grid
+	void PrepareGrid();
+
+	// voxelizes the static geometry of the level, saves it for this map and loads it
+	// if the grid can't be saved it is still used until the map is unloaded
+	// returns false if there was nothing to bake
+	bool BakeAndSave();
+
+	// voxelizes the static geometry of the level and uses it until the map is unloaded, without saving it
+	bool BakeInMemory();
+
+	// loads the baked grid for this map if there is one
+	bool LoadGrid();
+
+	// unmaps the grid
+	void ReleaseGrid();
+
+	// true once a grid has been loaded for this map
+	bool hasGrid() const { return voxelBits != NULL; }
+
+	// world space box the grid covers
+	FBox getGridBounds() const;
+
+	// file the grid for this map is saved to
+	FString GetGridFilename() const;
+
+protected:
+
+	/** if false every check is Unknown and flashes are traced the way they were before the grid */
+	UPROPERTY(config)
+	bool useBakedGrid;
+
+	/** if true a map with no saved grid is baked when play starts, or the first time a check is made */
+	UPROPERTY(config)
+	bool bakeIfMissing;
+
+	/** size of a voxel along each side */
+	UPROPERTY(config)
+	float voxelSize;
+
+	/** largest number of voxels a grid can have, bigger levels need a bigger voxel size */
+	UPROPERTY(config)
+	int32 maxVoxels;
+
+	// header of the loaded grid
+	FFlashOcclusionGridHeader header;
+
+	// one bit per voxel, x first then y then z, pointing into the mapped file or the loaded data
+	const uint8* voxelBits;
+
+	// the mapped grid file, the region has to be released before the file
+	TUniquePtr<IMappedFileHandle> mappedFile;
+	TUniquePtr<IMappedFileRegion> mappedRegion;
+
+	// used instead of mapping on platforms that can't map files
+	TArray<uint8> loadedData;
+
+	// true once loading has been tried for this map, so a missing grid isn't looked for on every check
+	bool hasTriedLoad;
+
+	// voxelizes the static geometry into the header and voxel bits of a grid file
+	// returns false if there was nothing to bake
+	bool BakeGridData(TArray<uint8>& outFileData);
+
+	// points voxelBits at the data after the header, returns false if the data isn't a valid grid
+	bool SetGridData(const uint8* data, int64 dataSize);
+
+	// voxel containing the location, can be outside the grid
+	FIntVector GetVoxelCoord(const FVector& location) const;
+
+	// true if the voxel is inside the grid and holds static geometry
+	bool IsVoxelSolid(const FIntVector& voxel) const;
+
+	// steps through every voxel the line crosses, returns true if a solid voxel is found
+	bool WalkGrid(const FVector& start, const FVector& end) const;
+
+	// box around every static, collidable component in the level
+	FBox GetStaticGeometryBounds() const;
+};
@@ -0,0 +1,150 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "FlashbangResolver.h"
+#include "CourseworkCode.h"
+#include "CourseworkCodeCharacter.h"
+#include "FlashEffectComponent.h"
+#include "FlashOcclusionGrid.h"
+#include "Camera/CameraComponent.h"
+#include "Engine/World.h"
+
+DECLARE_CYCLE_STAT(TEXT("Flashbang Detonate"), STAT_FlashbangDetonate, STATGROUP_CourseworkCode);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Flashbang Listeners In Range"), STAT_FlashbangListeners, STATGROUP_CourseworkCode);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Flashbang Listeners Flashed"), STAT_FlashbangFlashed, STATGROUP_CourseworkCode);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Flashbang Listeners Occluded By Grid"), STAT_FlashbangGridOccluded, STATGROUP_CourseworkCode);
+
+// sets default flash settings, these can be overridden in DefaultGame.ini
+UFlashbangResolver::UFlashbangResolver()
+{
+	flashRange = 2000.0f;
+	lineOfSightChannel = ECC_Visibility;
+
+	// the custom "SageWall" object channel used by the sage cube collision profile
+	dynamicBlockerTypes.Add(ECC_GameTraceChannel2);
+	confirmBlockedWithTrace = true;
+	nextTraceId = 0;
+}
+
+void UFlashbangResolver::Deinitialize()
+{
+	pendingListeners.Empty();
+	overlaps.Empty();
+	flashListeners.Reset();
+
+	Super::Deinitialize();
+}
+
+// the overlap only touches pawns near the flash, so the cost follows the number of nearby listeners
+void UFlashbangResolver::Detonate(const FVector& flashLocation, AActor* flashActor)
+{
+	SCOPE_CYCLE_COUNTER(STAT_FlashbangDetonate);
+
+	UWorld* const World = GetWorld();
+	if (World == NULL)
+	{
+		return;
+	}
+
+	FCollisionQueryParams overlapParams(SCENE_QUERY_STAT(FlashbangOverlap), false, flashActor);
+
+	overlaps.Reset();
+	World->OverlapMultiByObjectType(overlaps, flashLocation, FQuat::Identity, FCollisionObjectQueryParams(ECC_Pawn), FCollisionShape::MakeSphere(flashRange), overlapParams);
+
+	FTraceDelegate traceDelegate = FTraceDelegate::CreateUObject(this, &UFlashbangResolver::OnLineOfSightTraceDone);
+
+	UFlashOcclusionGrid* occlusionGrid = World->GetSubsystem<UFlashOcclusionGrid>();
+
+	FCollisionObjectQueryParams dynamicBlockerParams;
+	for (const TEnumAsByte<ECollisionChannel>& blockerType : dynamicBlockerTypes)
+	{
+		dynamicBlockerParams.AddObjectTypesToQuery(blockerType);
+	}
+
+	// a pawn can overlap with more than one component, so each one is only traced once
+	TArray<ACourseworkCodeCharacter*, TInlineAllocator<16>> listeners;
+	flashListeners.Reset();
+
+	for (const FOverlapResult& overlap : overlaps)
+	{
+		ACourseworkCodeCharacter* listener = Cast<ACourseworkCodeCharacter>(overlap.GetActor());
+		if (listener == NULL || listeners.Contains(listener))
+		{
+			continue;
+		}
+
+		listeners.Add(listener);
+
+		const UCameraComponent* camera = listener->GetFirstPersonCameraComponent();
+		flashListeners.Add(camera->GetComponentLocation(), camera->GetForwardVector());
+	}
+
+	// the intensity of every listener is worked out in one go, before any of them are traced
+	FlashExposureKernel::EvaluateVectorized(flashListeners, flashLocation, 0, flashListeners.Num());
+
+	for (int32 i = 0; i < listeners.Num(); i++)
+	{
+		ACourseworkCodeCharacter* listener = listeners[i];
+
+		// the camera can be out of range even when the capsule overlaps the edge of the range
+		if (flashListeners.intensity[i] == 0.0f)
+		{
+			continue;
+		}
+
+		const FVector cameraLocation = flashListeners.GetCameraLocation(i);
+
+		// static geometry in the way means there is nothing left to trace, unless the grid's answer has to be confirmed
+		const EFlashOcclusion occlusion = occlusionGrid != NULL ? occlusionGrid->QueryLineOfSight(flashLocation, cameraLocation) : EFlashOcclusion::Unknown;
+		if (occlusion == EFlashOcclusion::Blocked && !confirmBlockedWithTrace)
+		{
+			INC_DWORD_STAT(STAT_FlashbangGridOccluded);
+			continue;
+		}
+
+		FPendingFlashListener pendingListener;
+		pendingListener.listener = listener;
+		pendingListener.flashLocation = flashLocation;
+		pendingListener.intensity = flashListeners.intensity[i];
+
+		// the flash and the listener don't block their own line of sight
+		FCollisionQueryParams traceParams(SCENE_QUERY_STAT(FlashbangLineOfSight), false, flashActor);
+		traceParams.AddIgnoredActor(listener);
+
+		const uint32 traceId = nextTraceId++;
+		pendingListeners.Add(traceId, pendingListener);
+
+		// once the grid has cleared the baked geometry only the blocker object types are traced, everything static is skipped
+		if (occlusion == EFlashOcclusion::Visible)
+		{
+			World->AsyncLineTraceByObjectType(EAsyncTraceType::Test, flashLocation, cameraLocation, dynamicBlockerParams, traceParams, &traceDelegate, traceId);
+		}
+
+		else
+		{
+			World->AsyncLineTraceByChannel(EAsyncTraceType::Test, flashLocation, cameraLocation, lineOfSightChannel, traceParams, FCollisionResponseParams::DefaultResponseParam, &traceDelegate, traceId);
+		}
+	}
+
+	INC_DWORD_STAT_BY(STAT_FlashbangListeners, listeners.Num());
+}
+
+// flashes the listener if nothing blocked its line of sight
+void UFlashbangResolver::OnLineOfSightTraceDone(const FTraceHandle& traceHandle, FTraceDatum& traceData)
+{
+	FPendingFlashListener pendingListener;
+	if (!pendingListeners.RemoveAndCopyValue(traceData.UserData, pendingListener))
+	{
+		return;
+	}
+
+	const bool isBlocked = traceData.OutHits.Num() > 0;
+
+	ACourseworkCodeCharacter* listener = pendingListener.listener.Get();
+	if (listener != NULL && listener->GetFlashEffect() != NULL && !isBlocked)
+	{
+		listener->GetFlashEffect()->AddFlash(pendingListener.intensity);
+
+		INC_DWORD_STAT(STAT_FlashbangFlashed);
+	}
+}
@@ -0,0 +1,82 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "WorldCollision.h"
+#include "FlashExposureKernel.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "FlashbangResolver.generated.h"
+
+class ACourseworkCodeCharacter;
+
+/** a listener waiting on its line of sight trace to a flash */
+struct FPendingFlashListener
+{
+	TWeakObjectPtr<ACourseworkCodeCharacter> listener;
+	FVector flashLocation;
+
+	// flash amount worked out by the exposure kernel, given to the listener's flash effect if it can see the flash
+	float intensity;
+};
+
+/**
+ * World subsystem that works out who is caught by a Curveball flash
+ * only pawns inside the flash range are found, through a single overlap query
+ * and the line of sight to each of them is traced in the async trace batch instead of on the game thread
+ * if the map has a baked occlusion grid, listeners it clears of static geometry only trace against the blocker object types
+ * listeners it finds behind static geometry are traced normally, or dropped without a trace if confirmBlockedWithTrace is off
+ */
+UCLASS(config=Game)
+class COURSEWORKCODE_API UFlashbangResolver : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	UFlashbangResolver();
+
+	virtual void Deinitialize() override;
+
+	// finds every listener in range of the flash and traces their line of sight to it
+	// listeners that can see the flash are flashed once the traces come back, normally the next frame
+	void Detonate(const FVector& flashLocation, AActor* flashActor);
+
+	// distance beyond which listeners are never flashed
+	float getFlashRange() const { return flashRange; }
+
+protected:
+
+	/** distance beyond which listeners are never flashed */
+	UPROPERTY(config)
+	float flashRange;
+
+	/** channel the line of sight traces are run on, anything blocking it stops the flash */
+	UPROPERTY(config)
+	TEnumAsByte<ECollisionChannel> lineOfSightChannel;
+
+	/** object types still traced when the occlusion grid has cleared the baked geometry, anything that moves and should block a flash needs to use one of them
+	only the "SageWall" object type by default, so pawns, physics props and other movable objects don't block a flash the grid has cleared */
+	UPROPERTY(config)
+	TArray<TEnumAsByte<ECollisionChannel>> dynamicBlockerTypes;
+
+	/** if true listeners the occlusion grid blocks are still traced, so the grid never stops a flash a trace would let through
+	if false they are dropped without a trace, which is cheaper but denies a few flashes that pass close to static geometry, up to 5% of clear lines */
+	UPROPERTY(config)
+	bool confirmBlockedWithTrace;
+
+	// listeners waiting on their trace, by the user data given to the trace
+	TMap<uint32, FPendingFlashListener> pendingListeners;
+
+	// id given to the next trace
+	uint32 nextTraceId;
+
+	// called by the async trace system once a line of sight trace has finished
+	void OnLineOfSightTraceDone(const FTraceHandle& traceHandle, FTraceDatum& traceData);
+
+	// overlap results, kept between flashes to avoid reallocating
+	TArray<FOverlapResult> overlaps;
+
+	// cameras of the listeners in range of the current flash, kept between flashes to avoid reallocating
+	FFlashListenerSoA flashListeners;
+};
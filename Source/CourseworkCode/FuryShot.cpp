@@ -4,15 +4,19 @@
 #include "FuryShot.h"
 #include "CourseworkCodeCharacter.h"
 #include "SageCube.h"
+#include "PlacedSageWall.h"
+#include "DamageResolutionQueue.h"
+#include "FuryShotKernel.h"
 #include "Engine/StaticMesh.h"
+#include "Kismet/GameplayStatics.h"
+#include "Particles/ParticleSystem.h"
 #include "Runtime/CoreUObject/Public/UObject/ConstructorHelpers.h"
-#include "Runtime/Engine/Classes/Kismet/GameplayStatics.h"
 
 // Sets default values
 AFuryShot::AFuryShot()
 {
- 	// Set this actor to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
-	PrimaryActorTick.bCanEverTick = true;
+ 	// fury shots never tick, the fury state is set when fired and pushed through the shooter's delegate after that
+	PrimaryActorTick.bCanEverTick = false;
 
 	
 
@@ -36,8 +40,9 @@ AFuryShot::AFuryShot()
 
 	// uses a low gravity value and high velocity value
 	// to mimick real bullet movement
+	furyInitialVelocity = FVector(5000.0f, 0.0f, 0.0f);
 	furyProjectileMovement->ProjectileGravityScale = 0.2f;
-	furyProjectileMovement->Velocity = FVector(5000.0f, 0.0f, 0.0f);
+	furyProjectileMovement->Velocity = furyInitialVelocity;
 
 
 	// set up the static mesh component for the fury shot
@@ -57,93 +62,203 @@ AFuryShot::AFuryShot()
 
 	}
 
-	furyParticle = CreateDefaultSubobject<UParticleSystemComponent>(TEXT("FlameParticles"));
-	furyParticle->SetupAttachment(RootComponent);
-	furyParticle->bAutoActivate = false;
-	furyParticle->SetRelativeScale3D(FVector(2.0f, 2.0f, 2.0f));
+	// the flame effect is only loaded here, shots take a component from the particle pool when they are empowered
+	// so ordinary shots never carry a particle component
+	furyParticle = NULL;
+	furyParticleTemplate = NULL;
+	furyParticleScale = FVector(2.0f, 2.0f, 2.0f);
 
 	static ConstructorHelpers::FObjectFinder<UParticleSystem> ParticleAsset(TEXT("/Game/StarterContent/Particles/P_Fire.P_Fire"));
 
 	if (ParticleAsset.Succeeded())
 	{
-		furyParticle->SetTemplate(ParticleAsset.Object);
+		furyParticleTemplate = ParticleAsset.Object;
 	}
 
 	// Die after 5 seconds by default
 	InitialLifeSpan = 5.0f;
 
 
-	// set initial damage value
-	damage = 50;
+	// set initial damage values
+	standardDamage = 50;
+	furyDamage = 100;
+	damage = standardDamage;
+	liveFuryUpdates = false;
 }
 
 
 // checks if the projectile is colliding with a sage cube
-// if it collides with one, take damage away from the sage cube
-// if not, destroy the projectile
+// if it collides with one, queue damage for the sage cube
+// either way the projectile goes back to the pool
 void AFuryShot::OnSageCubeBeginOverlap(UPrimitiveComponent* HitComp, AActor* OtherActor, UPrimitiveComponent* OtherComp, FVector NormalImpulse, const FHitResult& Hit)
 {
+	ApplyFuryDamage(Hit, damage);
 
-	// casts to the sage cube class in order to access it's variables and functions
-	class ASageCube* sageCube = Cast<ASageCube>(OtherActor);
+	// return the projectile to the pool
+	UAbilityActorPool::ReleaseOrDestroy(this);
+}
+
+// queues the damage for the hit actor if it is a sage cube or a sage wall segment
+// the damage is applied once per frame by the damage resolution queue, adding up every hit on the same cube
+void AFuryShot::ApplyFuryDamage(const FHitResult& Hit, int damageAmount)
+{
+	AActor* OtherActor = Hit.GetActor();
+
+	// only sage cubes take damage from fury shots
+	if (OtherActor != NULL && OtherActor->IsA<ASageCube>())
+	{
+		UDamageResolutionQueue::QueueDamage(OtherActor, damageAmount);
+	}
 
-	// checks if collided actor is not null and if it is a sage cube
-	// if it is a sage cube and not null, deal damage to cube
-	if (OtherActor != NULL && OtherActor == sageCube)
+	// each segment of a placed wall is an instance, the hit item says which one was hit
+	// an async sweep can report an item from before a segment was removed, so it is checked against the impact point
+	else if (OtherActor != NULL && OtherActor->IsA<APlacedSageWall>())
 	{
-		int changeCubeHealth;
-		
-		// calculates new health value
-		changeCubeHealth = sageCube->getCubeHealth() - damage;
+		const int32 hitInstance = CastChecked<APlacedSageWall>(OtherActor)->FindHitInstance(Hit.Item, Hit.ImpactPoint);
+		if (hitInstance != INDEX_NONE)
+		{
+			UDamageResolutionQueue::QueueDamage(OtherActor, damageAmount, hitInstance);
+		}
+	}
 
-		// sets new health value for cube
-		sageCube->setCubeHealth(changeCubeHealth);
+}
 
-		// destroy the projectile
-		Destroy();
+// reads the Fury Shot state from the player that fired the shot
+void AFuryShot::InitFromShooter(ACourseworkCodeCharacter* shooter)
+{
+	if (shooter == NULL)
+	{
+		return;
 	}
 
-	// if it isnt a sage cube or the actor is null
-	else
+	SetFuryState(shooter->getIsFuryActivated());
+
+	// only follow the shooter's fury state after firing if asked to
+	if (liveFuryUpdates)
 	{
-		// destroy the projectile
-		Destroy();
+		furyShooter = shooter;
+		shooter->OnFuryStateChanged.AddUniqueDynamic(this, &AFuryShot::OnShooterFuryStateChanged);
 	}
-	
+}
+
+// places a shot fired part way through the frame where it would be by now
+void AFuryShot::AdvanceSpawnTime(float shotAge)
+{
+	if (shotAge <= 0.0f)
+	{
+		return;
+	}
+
+	FVector shotLocation = GetActorLocation();
+	FVector shotVelocity = furyProjectileMovement->Velocity;
+	FuryShotKernel::ExtrapolateShot(shotLocation, shotVelocity, furyProjectileMovement->GetGravityZ(), shotAge);
+
+	furyProjectileMovement->Velocity = shotVelocity;
+	SetLifeSpan(FMath::Max(InitialLifeSpan - shotAge, KINDA_SMALL_NUMBER));
 
+	// a blocking hit on the way calls the hit event, which hands the shot back to the pool
+	SetActorLocation(shotLocation, true);
 }
 
-// Called when the game starts or when spawned
-void AFuryShot::BeginPlay()
+// sets the damage and turns the flame effect on or off
+void AFuryShot::SetFuryState(bool isFuryActivated)
 {
-	Super::BeginPlay();
-	
+	// check if fury shot ability is active
+	// if it is, set damage to double of standard damage
+	// if it isn't, set damage back to standard damage
+	damage = getDamageForFury(isFuryActivated);
+
+	if (isFuryActivated)
+	{
+		AttachFuryParticle();
+	}
+	else
+	{
+		ReleaseFuryParticle();
+	}
 }
 
-// Called every frame
-void AFuryShot::Tick(float DeltaTime)
+void AFuryShot::AttachFuryParticle()
 {
-	Super::Tick(DeltaTime);
+	if (furyParticle != NULL || furyParticleTemplate == NULL)
+	{
+		return;
+	}
 
-	// casts to the player character in order to access the character variables and functions
-	class ACourseworkCodeCharacter* playerPawn = Cast<ACourseworkCodeCharacter>(UGameplayStatics::GetPlayerPawn(GetWorld(), 0));
+	// manual release keeps the component with this shot until it is handed back
+	furyParticle = UGameplayStatics::SpawnEmitterAttached(furyParticleTemplate, RootComponent, NAME_None, FVector::ZeroVector, FRotator::ZeroRotator,
+		furyParticleScale, EAttachLocation::KeepRelativeOffset, false, EPSCPoolMethod::ManualRelease);
+}
 
-	// check if fury shot ability is active
-	// if it is
-	if (playerPawn->getIsFuryActivated())
+void AFuryShot::ReleaseFuryParticle()
+{
+	if (furyParticle == NULL)
 	{
-		// set damage to double of standard damange
-		damage = 100;
-		furyParticle->SetActive(true);
+		return;
 	}
 
-	// if it isn't
-	else
+	// the pool detaches the component and reuses it once the flames have finished
+	furyParticle->ReleaseToPool();
+	furyParticle = NULL;
+}
+
+void AFuryShot::OnShooterFuryStateChanged(bool isFuryActivated)
+{
+	SetFuryState(isFuryActivated);
+}
+
+void AFuryShot::StopFuryUpdates()
+{
+	if (furyShooter.IsValid())
 	{
-		// set damage back to standard damage
-		damage = 50;
-		furyParticle->SetActive(false);
+		furyShooter->OnFuryStateChanged.RemoveDynamic(this, &AFuryShot::OnShooterFuryStateChanged);
 	}
 
+	furyShooter.Reset();
+}
+
+// resets the fury shot so it flies like a freshly spawned one
+void AFuryShot::OnAcquiredFromPool()
+{
+	// the movement component lets go of the sphere when it stops on a hit
+	// so it has to be given back before the shot can move again
+	furyProjectileMovement->SetUpdatedComponent(furySphereComp);
+	furyProjectileMovement->SetVelocityInLocalSpace(furyInitialVelocity);
+	furyProjectileMovement->Activate(true);
+
+	// restart the lifespan using the default value
+	SetLifeSpan(InitialLifeSpan);
+}
+
+// stops the fury shot from moving or expiring while it is inside the pool
+void AFuryShot::OnReleasedToPool()
+{
+	furyProjectileMovement->StopMovementImmediately();
+	furyProjectileMovement->Deactivate();
+	ReleaseFuryParticle();
+
+	SetLifeSpan(0.0f);
+
+	StopFuryUpdates();
+}
+
+// returns the fury shot to the pool once it has flown for its full lifespan
+void AFuryShot::LifeSpanExpired()
+{
+	UAbilityActorPool::ReleaseOrDestroy(this);
+}
+
+// Called when the game starts or when spawned
+void AFuryShot::BeginPlay()
+{
+	Super::BeginPlay();
+	
 }
 
+void AFuryShot::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	StopFuryUpdates();
+	ReleaseFuryParticle();
+
+	Super::EndPlay(EndPlayReason);
+}
@@ -8,10 +8,13 @@
 #include "Components/SphereComponent.h"
 #include "Components/StaticMeshComponent.h"
 #include "GameFramework/Actor.h"
+#include "AbilityActorPool.h"
 #include "FuryShot.generated.h"
 
+class ACourseworkCodeCharacter;
+
 UCLASS()
-class COURSEWORKCODE_API AFuryShot : public AActor
+class COURSEWORKCODE_API AFuryShot : public AActor, public IPooledAbilityActor
 {
 	GENERATED_BODY()
 	
@@ -25,6 +28,28 @@ public:
 	UFUNCTION()
 		void OnSageCubeBeginOverlap(UPrimitiveComponent* HitComp, AActor* OtherActor, UPrimitiveComponent* OtherComp, FVector NormalImpulse, const FHitResult& Hit);
 
+	// queues the fury shot damage for the hit actor if it is a sage cube or a segment of a placed sage wall
+	// shared by the fury shot actor and the fury shot simulation
+	static void ApplyFuryDamage(const FHitResult& Hit, int damageAmount);
+
+	// sets the damage and flame effect from the Fury Shot state of the player that fired the shot
+	// if live fury updates are enabled the shot also follows any later changes to that state
+	void InitFromShooter(ACourseworkCodeCharacter* shooter);
+
+	// moves the shot forward along its path by the time since it was fired
+	// sweeps from the muzzle, so anything the shot would already have hit is still hit
+	void AdvanceSpawnTime(float shotAge);
+
+	// gets the damage a shot deals depending on if the Fury Shot ability is active
+	int getDamageForFury(bool isFuryActivated) const { return isFuryActivated ? furyDamage : standardDamage; }
+
+	// pool reset hooks
+	// restarts the projectile movement and lifespan when the fury shot is fired again
+	virtual void OnAcquiredFromPool() override;
+
+	// stops the projectile movement and lifespan while the fury shot waits in the pool
+	virtual void OnReleasedToPool() override;
+
 protected:
 
 
@@ -40,20 +65,77 @@ protected:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite)
 	UStaticMeshComponent* furyStaticMesh;
 
-	/** sets the particle to the actor */
+	/** flame effect attached to the shot while the Fury Shot ability is active */
 	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	UParticleSystem* furyParticleTemplate;
+
+	/** scale the flame effect is attached with */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	FVector furyParticleScale;
+
+	/** flame effect taken from the world's particle pool, only set while the shot is empowered */
+	UPROPERTY(Transient)
 	UParticleSystemComponent* furyParticle;
 
 	/** damage variable that controls how much damage the projectile does */
 	UPROPERTY(EditAnywhere, BlueprintReadWrite)
 	int damage;
 
+	/** velocity the fury shot is fired with, relative to its spawn rotation */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Movement)
+	FVector furyInitialVelocity;
+
+	/** damage dealt by shots fired without the Fury Shot ability */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int standardDamage;
+
+	/** damage dealt by shots fired while the Fury Shot ability is active */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int furyDamage;
+
+	/** if true the shot changes its damage and flame effect when the shooter's Fury Shot ability starts or ends mid-flight */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	bool liveFuryUpdates;
+
+	/** player that fired the shot, only kept while listening for fury changes */
+	UPROPERTY()
+	TWeakObjectPtr<ACourseworkCodeCharacter> furyShooter;
+
+	// applies the damage and flame effect for the given Fury Shot state
+	void SetFuryState(bool isFuryActivated);
+
+	// called by the shooter when its Fury Shot ability starts or ends
+	UFUNCTION()
+	void OnShooterFuryStateChanged(bool isFuryActivated);
+
+	// stops listening to the shooter's Fury Shot state
+	void StopFuryUpdates();
+
+	// takes a flame effect from the particle pool and attaches it to the shot
+	void AttachFuryParticle();
+
+	// hands the flame effect back to the particle pool
+	void ReleaseFuryParticle();
+
 protected:
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
 
+	// hands the fury shot back to the pool instead of destroying it
+	virtual void LifeSpanExpired() override;
+
+	// stops listening for fury changes if the shot is destroyed
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
 public:	
-	// Called every frame
-	virtual void Tick(float DeltaTime) override;
+
+	/** Returns furySphereComp subobject **/
+	FORCEINLINE USphereComponent* GetFurySphereComp() const { return furySphereComp; }
+	/** Returns furyProjectileMovement subobject **/
+	FORCEINLINE UProjectileMovementComponent* GetFuryProjectileMovement() const { return furyProjectileMovement; }
+	/** Returns furyStaticMesh subobject **/
+	FORCEINLINE UStaticMeshComponent* GetFuryStaticMesh() const { return furyStaticMesh; }
+	/** Returns the velocity the fury shot is fired with **/
+	FORCEINLINE FVector GetFuryInitialVelocity() const { return furyInitialVelocity; }
 
 };
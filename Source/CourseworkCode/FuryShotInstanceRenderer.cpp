@@ -0,0 +1,67 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "FuryShotInstanceRenderer.h"
+#include "CourseworkCode.h"
+#include "Components/InstancedStaticMeshComponent.h"
+#include "Engine/StaticMesh.h"
+
+DECLARE_CYCLE_STAT(TEXT("FuryShot Instance Update"), STAT_FuryShotInstanceUpdate, STATGROUP_CourseworkCode);
+DECLARE_DWORD_COUNTER_STAT(TEXT("FuryShot Instances"), STAT_FuryShotInstances, STATGROUP_CourseworkCode);
+
+// Sets default values
+AFuryShotInstanceRenderer::AFuryShotInstanceRenderer()
+{
+	// the fury shot simulation pushes the instance transforms, so this actor never needs to tick
+	PrimaryActorTick.bCanEverTick = false;
+
+	// set up the instanced mesh as the root, it is only ever drawn so it has no collision
+	shotInstances = CreateDefaultSubobject<UInstancedStaticMeshComponent>(TEXT("Shot Instances"));
+	shotInstances->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	shotInstances->SetCanEverAffectNavigation(false);
+	shotInstances->SetMobility(EComponentMobility::Movable);
+	RootComponent = shotInstances;
+
+	instanceScale = FVector(1.0f);
+}
+
+void AFuryShotInstanceRenderer::SetShotMesh(UStaticMesh* shotMesh, const FVector& shotScale)
+{
+	shotInstances->SetStaticMesh(shotMesh);
+	instanceScale = shotScale;
+}
+
+// writes every instance transform in one batch and only dirties the render state once
+void AFuryShotInstanceRenderer::UpdateInstances(const TArray<float>& posX, const TArray<float>& posY, const TArray<float>& posZ)
+{
+	SCOPE_CYCLE_COUNTER(STAT_FuryShotInstanceUpdate);
+
+	const int32 numShots = posX.Num();
+
+	// shots are spheres so they only need a location and scale
+	instanceTransforms.SetNum(numShots, false);
+	for (int32 i = 0; i < numShots; i++)
+	{
+		instanceTransforms[i] = FTransform(FQuat::Identity, FVector(posX[i], posY[i], posZ[i]), instanceScale);
+	}
+
+	// remove instances from the end so no other instance has to be shuffled down
+	while (shotInstances->GetInstanceCount() > numShots)
+	{
+		shotInstances->RemoveInstance(shotInstances->GetInstanceCount() - 1);
+	}
+
+	// new shots get their own instance
+	for (int32 i = shotInstances->GetInstanceCount(); i < numShots; i++)
+	{
+		shotInstances->AddInstanceWorldSpace(instanceTransforms[i]);
+	}
+
+	// move every instance in one batch
+	if (numShots > 0)
+	{
+		shotInstances->BatchUpdateInstancesTransforms(0, instanceTransforms, true, true, true);
+	}
+
+	INC_DWORD_STAT_BY(STAT_FuryShotInstances, numShots);
+}
@@ -0,0 +1,42 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "FuryShotInstanceRenderer.generated.h"
+
+class UInstancedStaticMeshComponent;
+class UStaticMesh;
+
+/**
+ * Draws every Fury Shot in the fury shot simulation through one instanced static mesh component
+ * so hundreds of bullets only cost a single render proxy
+ */
+UCLASS(NotPlaceable, Transient)
+class COURSEWORKCODE_API AFuryShotInstanceRenderer : public AActor
+{
+	GENERATED_BODY()
+
+public:
+	// Sets default values for this actor's properties
+	AFuryShotInstanceRenderer();
+
+	// sets the mesh and scale every shot is drawn with
+	void SetShotMesh(UStaticMesh* shotMesh, const FVector& shotScale);
+
+	// moves one instance to each shot location, adding or removing instances to match the number of shots
+	void UpdateInstances(const TArray<float>& posX, const TArray<float>& posY, const TArray<float>& posZ);
+
+protected:
+
+	/** instanced mesh component that draws all of the shots */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
+	UInstancedStaticMeshComponent* shotInstances;
+
+	/** scale applied to every instance */
+	FVector instanceScale;
+
+	// instance transforms, kept between frames to avoid reallocating
+	TArray<FTransform> instanceTransforms;
+};
@@ -0,0 +1,357 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "FuryShotKernel.h"
+#include "GameFramework/Actor.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformTime.h"
+#include "Math/RandomStream.h"
+#include "Math/VectorRegister.h"
+#include "Misc/AutomationTest.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogFuryShotKernel, Log, All);
+
+//////////////////////////////////////////////////////////////////////////
+// FFuryShotSoA
+
+int32 FFuryShotSoA::Add(const FVector& location, const FVector& velocity, float inGravityScale, float inLifetime, float inCollisionRadius, int inDamage, AActor* inShooter)
+{
+	posX.Add(location.X);
+	posY.Add(location.Y);
+	posZ.Add(location.Z);
+
+	prevX.Add(location.X);
+	prevY.Add(location.Y);
+	prevZ.Add(location.Z);
+
+	velX.Add(velocity.X);
+	velY.Add(velocity.Y);
+	velZ.Add(velocity.Z);
+
+	gravityScale.Add(inGravityScale);
+	lifetime.Add(inLifetime);
+
+	collisionRadius.Add(inCollisionRadius);
+	damage.Add(inDamage);
+
+	return shooter.Add(inShooter);
+}
+
+void FFuryShotSoA::SetNum(int32 newNum)
+{
+	posX.SetNumZeroed(newNum, false);
+	posY.SetNumZeroed(newNum, false);
+	posZ.SetNumZeroed(newNum, false);
+
+	prevX.SetNumZeroed(newNum, false);
+	prevY.SetNumZeroed(newNum, false);
+	prevZ.SetNumZeroed(newNum, false);
+
+	velX.SetNumZeroed(newNum, false);
+	velY.SetNumZeroed(newNum, false);
+	velZ.SetNumZeroed(newNum, false);
+
+	gravityScale.SetNumZeroed(newNum, false);
+	lifetime.SetNumZeroed(newNum, false);
+
+	collisionRadius.SetNumZeroed(newNum, false);
+	damage.SetNumZeroed(newNum, false);
+	shooter.SetNum(newNum, false);
+}
+
+void FFuryShotSoA::Reset()
+{
+	SetNum(0);
+}
+
+void FFuryShotSoA::Empty()
+{
+	*this = FFuryShotSoA();
+}
+
+//////////////////////////////////////////////////////////////////////////
+// FuryShotKernel
+
+// gravity is constant, so the exact position is found in one step
+// this gives the same result as the integrators, which are exact for constant acceleration
+void FuryShotKernel::ExtrapolateShot(FVector& location, FVector& velocity, float gravityZ, float time)
+{
+	location += velocity * time;
+	location.Z += 0.5f * gravityZ * time * time;
+	velocity.Z += gravityZ * time;
+}
+
+// moves each shot by averaging its velocity before and after gravity is applied
+// which matches UProjectileMovementComponent::ComputeMoveDelta
+// this is exact for constant gravity, so splitting the frame into sub-steps would land on the same position
+// the sweep runs straight from the start to the end of the frame, the arc between them sags by gravity * time^2 / 8
+// which is under two units at the fury shot's gravity scale even for a quarter second frame, far less than the shot's collision radius
+void FuryShotKernel::IntegrateScalar(FFuryShotSoA& shots, int32 startIndex, int32 count, float deltaTime, float gravityZ)
+{
+	const float halfDeltaTime = 0.5f * deltaTime;
+	const int32 endIndex = startIndex + count;
+
+	for (int32 i = startIndex; i < endIndex; i++)
+	{
+		const float gravityStep = gravityZ * shots.gravityScale[i] * deltaTime;
+
+		shots.prevX[i] = shots.posX[i];
+		shots.prevY[i] = shots.posY[i];
+		shots.prevZ[i] = shots.posZ[i];
+
+		// gravity only acts on Z so the horizontal movement can be done in one go
+		shots.posX[i] = shots.velX[i] * deltaTime + shots.posX[i];
+		shots.posY[i] = shots.velY[i] * deltaTime + shots.posY[i];
+
+		const float newVelZ = shots.velZ[i] + gravityStep;
+
+		shots.posZ[i] = (shots.velZ[i] + newVelZ) * halfDeltaTime + shots.posZ[i];
+		shots.velZ[i] = newVelZ;
+
+		shots.lifetime[i] -= deltaTime;
+	}
+}
+
+// same maths as the scalar path, but four shots are loaded into each vector register
+void FuryShotKernel::IntegrateVectorized(FFuryShotSoA& shots, int32 startIndex, int32 count, float deltaTime, float gravityZ)
+{
+	const VectorRegister deltaTimeReg = VectorSetFloat1(deltaTime);
+	const VectorRegister halfDeltaTimeReg = VectorSetFloat1(0.5f * deltaTime);
+	const VectorRegister gravityStepReg = VectorSetFloat1(gravityZ * deltaTime);
+
+	const int32 endIndex = startIndex + count;
+	const int32 vectorEndIndex = startIndex + (count & ~3);
+
+	float* RESTRICT posX = shots.posX.GetData();
+	float* RESTRICT posY = shots.posY.GetData();
+	float* RESTRICT posZ = shots.posZ.GetData();
+	float* RESTRICT prevX = shots.prevX.GetData();
+	float* RESTRICT prevY = shots.prevY.GetData();
+	float* RESTRICT prevZ = shots.prevZ.GetData();
+	const float* RESTRICT velX = shots.velX.GetData();
+	const float* RESTRICT velY = shots.velY.GetData();
+	float* RESTRICT velZ = shots.velZ.GetData();
+	const float* RESTRICT gravityScale = shots.gravityScale.GetData();
+	float* RESTRICT lifetime = shots.lifetime.GetData();
+
+	for (int32 i = startIndex; i < vectorEndIndex; i += 4)
+	{
+		VectorRegister px = VectorLoad(posX + i);
+		VectorRegister py = VectorLoad(posY + i);
+		VectorRegister pz = VectorLoad(posZ + i);
+
+		VectorStore(px, prevX + i);
+		VectorStore(py, prevY + i);
+		VectorStore(pz, prevZ + i);
+
+		// gravity only acts on Z so the horizontal movement can be done in one go
+		px = VectorMultiplyAdd(VectorLoad(velX + i), deltaTimeReg, px);
+		py = VectorMultiplyAdd(VectorLoad(velY + i), deltaTimeReg, py);
+
+		const VectorRegister vz = VectorLoad(velZ + i);
+		const VectorRegister newVz = VectorMultiplyAdd(VectorLoad(gravityScale + i), gravityStepReg, vz);
+
+		pz = VectorMultiplyAdd(VectorAdd(vz, newVz), halfDeltaTimeReg, pz);
+
+		VectorStore(px, posX + i);
+		VectorStore(py, posY + i);
+		VectorStore(pz, posZ + i);
+		VectorStore(newVz, velZ + i);
+
+		VectorStore(VectorSubtract(VectorLoad(lifetime + i), deltaTimeReg), lifetime + i);
+	}
+
+	// finish any shots that didn't fill a full register
+	if (vectorEndIndex < endIndex)
+	{
+		IntegrateScalar(shots, vectorEndIndex, endIndex - vectorEndIndex, deltaTime, gravityZ);
+	}
+}
+
+// slides every live shot down over the expired ones in a single pass
+int32 FuryShotKernel::CompactExpired(FFuryShotSoA& shots)
+{
+	const int32 numShots = shots.Num();
+	int32 writeIndex = 0;
+
+	for (int32 readIndex = 0; readIndex < numShots; readIndex++)
+	{
+		if (shots.lifetime[readIndex] <= 0.0f)
+		{
+			continue;
+		}
+
+		if (writeIndex != readIndex)
+		{
+			shots.posX[writeIndex] = shots.posX[readIndex];
+			shots.posY[writeIndex] = shots.posY[readIndex];
+			shots.posZ[writeIndex] = shots.posZ[readIndex];
+
+			shots.prevX[writeIndex] = shots.prevX[readIndex];
+			shots.prevY[writeIndex] = shots.prevY[readIndex];
+			shots.prevZ[writeIndex] = shots.prevZ[readIndex];
+
+			shots.velX[writeIndex] = shots.velX[readIndex];
+			shots.velY[writeIndex] = shots.velY[readIndex];
+			shots.velZ[writeIndex] = shots.velZ[readIndex];
+
+			shots.gravityScale[writeIndex] = shots.gravityScale[readIndex];
+			shots.lifetime[writeIndex] = shots.lifetime[readIndex];
+
+			shots.collisionRadius[writeIndex] = shots.collisionRadius[readIndex];
+			shots.damage[writeIndex] = shots.damage[readIndex];
+			shots.shooter[writeIndex] = shots.shooter[readIndex];
+		}
+
+		writeIndex++;
+	}
+
+	shots.SetNum(writeIndex);
+
+	return numShots - writeIndex;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Benchmark
+
+#if !UE_BUILD_SHIPPING
+
+namespace FuryShotKernelBenchmark
+{
+	// timings of both kernels for one number of shots
+	struct FResult
+	{
+		double scalarMs;
+		double vectorMs;
+		double compactMs;
+		float maxError;
+		int32 numExpired;
+	};
+
+	// fills the buffer with shots fired in random directions using the fury shot defaults
+	static void FillShots(FFuryShotSoA& shots, int32 numShots)
+	{
+		FRandomStream random(1234);
+
+		shots.Reset();
+
+		for (int32 i = 0; i < numShots; i++)
+		{
+			const FRotator fireRotation(random.FRandRange(-30.0f, 30.0f), random.FRandRange(-180.0f, 180.0f), 0.0f);
+			const FVector fireVelocity = fireRotation.RotateVector(FVector(5000.0f, 0.0f, 0.0f));
+
+			// spread the lifetimes so every frame has some shots expiring
+			shots.Add(random.GetUnitVector() * 1000.0f, fireVelocity, 0.2f, random.FRandRange(0.5f, 5.0f), 26.0f, 50, nullptr);
+		}
+	}
+
+	// times one integration path over a number of frames and returns the average milliseconds per frame
+	template<typename KernelFunc>
+	static double TimeKernel(FFuryShotSoA& shots, int32 numFrames, float deltaTime, KernelFunc kernel)
+	{
+		const double startTime = FPlatformTime::Seconds();
+
+		for (int32 frame = 0; frame < numFrames; frame++)
+		{
+			kernel(shots, 0, shots.Num(), deltaTime, -980.0f);
+		}
+
+		return (FPlatformTime::Seconds() - startTime) * 1000.0 / numFrames;
+	}
+
+	// runs the scalar and vectorized kernels on the same shots and logs the timings
+	// only the shot buffers are touched, so no world or rendering is needed
+	static FResult Measure(int32 numShots, int32 numFrames)
+	{
+		const float deltaTime = 1.0f / 60.0f;
+
+		FFuryShotSoA scalarShots;
+		FFuryShotSoA vectorShots;
+		FillShots(scalarShots, numShots);
+		FillShots(vectorShots, numShots);
+
+		FResult result;
+		result.scalarMs = TimeKernel(scalarShots, numFrames, deltaTime, &FuryShotKernel::IntegrateScalar);
+		result.vectorMs = TimeKernel(vectorShots, numFrames, deltaTime, &FuryShotKernel::IntegrateVectorized);
+
+		// both paths should land every shot in the same place
+		result.maxError = 0.0f;
+		for (int32 i = 0; i < numShots; i++)
+		{
+			result.maxError = FMath::Max(result.maxError, FVector::Dist(scalarShots.GetPosition(i), vectorShots.GetPosition(i)));
+		}
+
+		const double compactStartTime = FPlatformTime::Seconds();
+		result.numExpired = FuryShotKernel::CompactExpired(vectorShots);
+		result.compactMs = (FPlatformTime::Seconds() - compactStartTime) * 1000.0;
+
+		UE_LOG(LogFuryShotKernel, Display, TEXT("%7d shots over %d frames: scalar %.4f ms, vectorized %.4f ms (%.2fx), max error %.4f, compacted %d expired in %.4f ms"),
+			numShots, numFrames, result.scalarMs, result.vectorMs, result.vectorMs > 0.0 ? result.scalarMs / result.vectorMs : 0.0, result.maxError, result.numExpired, result.compactMs);
+
+		return result;
+	}
+
+	static void Run(const TArray<FString>& args)
+	{
+		TArray<int32> shotCounts;
+		int32 numFrames = 300;
+
+		// arguments are shot counts, with an optional frames= value
+		for (const FString& arg : args)
+		{
+			if (arg.StartsWith(TEXT("frames=")))
+			{
+				numFrames = FMath::Max(1, FCString::Atoi(*arg.RightChop(7)));
+			}
+
+			else if (arg.IsNumeric())
+			{
+				shotCounts.Add(FMath::Max(1, FCString::Atoi(*arg)));
+			}
+		}
+
+		if (shotCounts.Num() == 0)
+		{
+			shotCounts = { 1000, 10000, 100000 };
+		}
+
+		for (int32 numShots : shotCounts)
+		{
+			Measure(numShots, numFrames);
+		}
+	}
+
+	static FAutoConsoleCommand BenchmarkCommand(
+		TEXT("FuryShot.Benchmark"),
+		TEXT("Compares the scalar and vectorized Fury Shot integration kernels. Usage: FuryShot.Benchmark [shot counts...] [frames=300]"),
+		FConsoleCommandWithArgsDelegate::CreateStatic(&Run));
+}
+
+#endif
+
+//////////////////////////////////////////////////////////////////////////
+// Tests
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFuryShotKernelBenchmarkTest, "CourseworkCode.FuryShot.KernelBenchmark", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::PerfFilter)
+
+// the benchmark on its own, so it can be run headless with -nullrhi through the automation commands
+// timings are only reported, a slow machine doesn't fail the test
+bool FFuryShotKernelBenchmarkTest::RunTest(const FString& Parameters)
+{
+	for (int32 numShots : { 1000, 10000, 100000 })
+	{
+		const FuryShotKernelBenchmark::FResult result = FuryShotKernelBenchmark::Measure(numShots, 300);
+
+		AddInfo(FString::Printf(TEXT("%d shots: scalar %.4f ms, vectorized %.4f ms (%.2fx)"),
+			numShots, result.scalarMs, result.vectorMs, result.vectorMs > 0.0 ? result.scalarMs / result.vectorMs : 0.0));
+
+		TestTrue(FString::Printf(TEXT("Vectorized kernel matches the scalar kernel for %d shots within 0.01 (%.5f)"), numShots, result.maxError), result.maxError < 0.01f);
+		TestTrue(FString::Printf(TEXT("Expired shots are compacted for %d shots"), numShots), result.numExpired > 0);
+	}
+
+	return true;
+}
+
+#endif
@@ -0,0 +1,76 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class AActor;
+
+/**
+ * Fury Shot data stored as a structure of arrays
+ * every array has one entry per shot so the movement kernel can load four shots into one vector register
+ */
+struct COURSEWORKCODE_API FFuryShotSoA
+{
+	// current position
+	TArray<float> posX;
+	TArray<float> posY;
+	TArray<float> posZ;
+
+	// position at the start of the last update, used as the start of the collision sweep
+	TArray<float> prevX;
+	TArray<float> prevY;
+	TArray<float> prevZ;
+
+	// current velocity
+	TArray<float> velX;
+	TArray<float> velY;
+	TArray<float> velZ;
+
+	// per shot movement settings
+	TArray<float> gravityScale;
+	TArray<float> lifetime;
+
+	// per shot gameplay data, only moved around by the kernel, never read
+	TArray<float> collisionRadius;
+	TArray<int> damage;
+	TArray<TWeakObjectPtr<AActor>> shooter;
+
+	int32 Num() const { return posX.Num(); }
+
+	// adds a shot to the end of every array and returns its index
+	int32 Add(const FVector& location, const FVector& velocity, float inGravityScale, float inLifetime, float inCollisionRadius, int inDamage, AActor* inShooter);
+
+	// resizes every array, new shots are zeroed
+	void SetNum(int32 newNum);
+
+	void Reset();
+	void Empty();
+
+	FVector GetPosition(int32 index) const { return FVector(posX[index], posY[index], posZ[index]); }
+	FVector GetPreviousPosition(int32 index) const { return FVector(prevX[index], prevY[index], prevZ[index]); }
+	FVector GetVelocity(int32 index) const { return FVector(velX[index], velY[index], velZ[index]); }
+};
+
+/**
+ * Ballistic integration kernels for Fury Shots
+ * uses the same integration as the projectile movement component with no drag or bounce
+ */
+namespace FuryShotKernel
+{
+	// moves shots [startIndex, startIndex + count) one shot at a time
+	// gravity is constant, so one step lands every shot exactly where it would be after the whole frame
+	COURSEWORKCODE_API void IntegrateScalar(FFuryShotSoA& shots, int32 startIndex, int32 count, float deltaTime, float gravityZ);
+
+	// moves shots [startIndex, startIndex + count) four at a time using vector registers
+	// any shots left over after the last group of four use the scalar path
+	COURSEWORKCODE_API void IntegrateVectorized(FFuryShotSoA& shots, int32 startIndex, int32 count, float deltaTime, float gravityZ);
+
+	// moves a single shot forward along its ballistic path by the given time
+	// used to back-date shots that were fired part way through the frame
+	COURSEWORKCODE_API void ExtrapolateShot(FVector& location, FVector& velocity, float gravityZ, float time);
+
+	// removes every shot with no lifetime left in one pass, keeping the order of the remaining shots
+	// returns the number of shots removed
+	COURSEWORKCODE_API int32 CompactExpired(FFuryShotSoA& shots);
+}
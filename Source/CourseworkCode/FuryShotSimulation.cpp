@@ -0,0 +1,228 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "FuryShotSimulation.h"
+#include "CourseworkCode.h"
+#include "FuryShot.h"
+#include "FuryShotInstanceRenderer.h"
+#include "Engine/World.h"
+#include "Async/ParallelFor.h"
+
+DECLARE_CYCLE_STAT(TEXT("FuryShot Sim Tick"), STAT_FuryShotSimTick, STATGROUP_CourseworkCode);
+DECLARE_CYCLE_STAT(TEXT("FuryShot Sim Resolve Sweeps"), STAT_FuryShotSimResolve, STATGROUP_CourseworkCode);
+DECLARE_CYCLE_STAT(TEXT("FuryShot Sim Integrate"), STAT_FuryShotSimIntegrate, STATGROUP_CourseworkCode);
+DECLARE_CYCLE_STAT(TEXT("FuryShot Sim Issue Sweeps"), STAT_FuryShotSimIssue, STATGROUP_CourseworkCode);
+DECLARE_DWORD_COUNTER_STAT(TEXT("FuryShot Sim Shots"), STAT_FuryShotSimShots, STATGROUP_CourseworkCode);
+
+// sets default simulation settings, these can be overridden in DefaultGame.ini
+UFuryShotSimulation::UFuryShotSimulation()
+{
+	parallelUpdateThreshold = 512;
+	parallelBatchSize = 1024;
+
+	// the custom "Projectile" object channel used by the fury shot collision profile
+	sweepChannel = ECC_GameTraceChannel1;
+
+	renderWithInstances = true;
+	instanceRenderer = NULL;
+}
+
+void UFuryShotSimulation::Deinitialize()
+{
+	shots.Empty();
+	pendingShots.Empty();
+	pendingSweeps.Empty();
+
+	if (instanceRenderer != NULL && !instanceRenderer->IsPendingKill())
+	{
+		instanceRenderer->Destroy();
+	}
+	instanceRenderer = NULL;
+
+	Super::Deinitialize();
+}
+
+// only tick inside game worlds that have shots to simulate or add, or sweeps to resolve
+bool UFuryShotSimulation::IsTickable() const
+{
+	UWorld* const World = GetWorld();
+
+	return World != NULL && World->IsGameWorld() && (shots.Num() > 0 || pendingShots.Num() > 0 || pendingSweeps.Num() > 0);
+}
+
+TStatId UFuryShotSimulation::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UFuryShotSimulation, STATGROUP_Tickables);
+}
+
+// adds a shot to the end of the packed arrays
+void UFuryShotSimulation::SpawnShot(TSubclassOf<AFuryShot> shotClass, const FVector& location, const FRotator& rotation, int damageAmount, AActor* shooter, double fireTime)
+{
+	if (shotClass == NULL)
+	{
+		return;
+	}
+
+	// read the movement settings from the fury shot defaults so blueprint changes still apply
+	const AFuryShot* shotDefaults = shotClass->GetDefaultObject<AFuryShot>();
+
+	if (renderWithInstances && instanceRenderer == NULL)
+	{
+		CreateInstanceRenderer(shotDefaults);
+	}
+
+	FPendingFuryShot pendingShot;
+	pendingShot.location = location;
+	pendingShot.velocity = rotation.RotateVector(shotDefaults->GetFuryInitialVelocity());
+	pendingShot.gravityScale = shotDefaults->GetFuryProjectileMovement()->ProjectileGravityScale;
+	pendingShot.lifetime = shotDefaults->InitialLifeSpan;
+	pendingShot.collisionRadius = shotDefaults->GetFurySphereComp()->GetUnscaledSphereRadius();
+	pendingShot.damage = damageAmount;
+	pendingShot.shooter = shooter;
+	pendingShot.fireTime = fireTime;
+
+	pendingShots.Add(pendingShot);
+}
+
+// spawns the actor that draws the shots, using the same mesh and scale as the fury shot actor
+void UFuryShotSimulation::CreateInstanceRenderer(const AFuryShot* shotDefaults)
+{
+	FActorSpawnParameters rendererSpawnParams;
+	rendererSpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	rendererSpawnParams.ObjectFlags |= RF_Transient;
+
+	instanceRenderer = GetWorld()->SpawnActor<AFuryShotInstanceRenderer>(FVector::ZeroVector, FRotator::ZeroRotator, rendererSpawnParams);
+
+	if (instanceRenderer != NULL)
+	{
+		const UStaticMeshComponent* shotMesh = shotDefaults->GetFuryStaticMesh();
+		instanceRenderer->SetShotMesh(shotMesh->GetStaticMesh(), shotMesh->GetRelativeScale3D());
+	}
+}
+
+// runs the three stages of the simulation for every shot
+void UFuryShotSimulation::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_FuryShotSimTick);
+
+	ResolveSweeps();
+	IntegrateShots(DeltaTime);
+	AddPendingShots();
+	IssueSweeps();
+
+	// push every shot location to the instanced mesh in one batch
+	// the last tick runs with no shots left, which clears the instances
+	if (instanceRenderer != NULL)
+	{
+		instanceRenderer->UpdateInstances(shots.posX, shots.posY, shots.posZ);
+	}
+
+	INC_DWORD_STAT_BY(STAT_FuryShotSimShots, shots.Num());
+}
+
+// reads back the sweeps issued last frame
+// shots that hit something deal their damage and are removed along with any expired shots
+void UFuryShotSimulation::ResolveSweeps()
+{
+	SCOPE_CYCLE_COUNTER(STAT_FuryShotSimResolve);
+
+	UWorld* const World = GetWorld();
+
+	// only shots that existed when the sweeps were issued have a result
+	// shots fired since then are appended after them and keep their indices
+	for (int32 i = 0; i < pendingSweeps.Num(); i++)
+	{
+		FTraceDatum sweepData;
+		if (!World->QueryTraceData(pendingSweeps[i], sweepData))
+		{
+			continue;
+		}
+
+		for (const FHitResult& hit : sweepData.OutHits)
+		{
+			if (hit.bBlockingHit)
+			{
+				// same damage logic as the fury shot actor hitting a sage cube
+				AFuryShot::ApplyFuryDamage(hit, shots.damage[i]);
+
+				// no lifetime left means the shot is removed with the expired ones
+				shots.lifetime[i] = 0.0f;
+				break;
+			}
+		}
+	}
+
+	pendingSweeps.Reset();
+
+	// remove every hit and expired shot in one pass
+	FuryShotKernel::CompactExpired(shots);
+}
+
+// moves every shot using the vectorized kernel
+// large numbers of shots are split into batches across worker threads
+void UFuryShotSimulation::IntegrateShots(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_FuryShotSimIntegrate);
+
+	const int32 numShots = shots.Num();
+	const float gravityZ = GetWorld()->GetGravityZ();
+
+	// keep batches a multiple of four so only the last batch has a scalar remainder
+	const int32 batchSize = FMath::Max(4, parallelBatchSize & ~3);
+	const int32 numBatches = FMath::DivideAndRoundUp(numShots, batchSize);
+
+	ParallelFor(numBatches, [this, DeltaTime, gravityZ, numShots, batchSize](int32 batchIndex)
+	{
+		const int32 startIndex = batchIndex * batchSize;
+		const int32 count = FMath::Min(batchSize, numShots - startIndex);
+
+		FuryShotKernel::IntegrateVectorized(shots, startIndex, count, DeltaTime, gravityZ);
+	}, numShots < parallelUpdateThreshold);
+}
+
+// adds every shot fired since the last update at the position it has reached by now
+// shots are fired part way through a frame, so each one has already flown for part of it
+void UFuryShotSimulation::AddPendingShots()
+{
+	const double currentTime = GetWorld()->GetTimeSeconds();
+	const float gravityZ = GetWorld()->GetGravityZ();
+
+	for (FPendingFuryShot& pendingShot : pendingShots)
+	{
+		const float shotAge = FMath::Max(0.0f, float(currentTime - pendingShot.fireTime));
+
+		FVector shotLocation = pendingShot.location;
+		FVector shotVelocity = pendingShot.velocity;
+		FuryShotKernel::ExtrapolateShot(shotLocation, shotVelocity, gravityZ * pendingShot.gravityScale, shotAge);
+
+		const int32 shotIndex = shots.Add(shotLocation, shotVelocity, pendingShot.gravityScale, pendingShot.lifetime - shotAge,
+			pendingShot.collisionRadius, pendingShot.damage, pendingShot.shooter.Get());
+
+		// the first sweep covers the distance already flown since the muzzle
+		shots.prevX[shotIndex] = pendingShot.location.X;
+		shots.prevY[shotIndex] = pendingShot.location.Y;
+		shots.prevZ[shotIndex] = pendingShot.location.Z;
+	}
+
+	pendingShots.Reset();
+}
+
+// issues every sweep in one pass so the physics scene can run them as a batch
+void UFuryShotSimulation::IssueSweeps()
+{
+	SCOPE_CYCLE_COUNTER(STAT_FuryShotSimIssue);
+
+	UWorld* const World = GetWorld();
+	const int32 numShots = shots.Num();
+
+	pendingSweeps.SetNum(numShots);
+
+	for (int32 i = 0; i < numShots; i++)
+	{
+		// ignore the player that fired the shot
+		FCollisionQueryParams sweepParams(SCENE_QUERY_STAT(FuryShotSweep), false, shots.shooter[i].Get());
+
+		pendingSweeps[i] = World->AsyncSweepByChannel(EAsyncTraceType::Single, shots.GetPreviousPosition(i), shots.GetPosition(i), FQuat::Identity, sweepChannel,
+			FCollisionShape::MakeSphere(shots.collisionRadius[i]), sweepParams);
+	}
+}
@@ -0,0 +1,105 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Tickable.h"
+#include "WorldCollision.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "FuryShotKernel.h"
+#include "FuryShotSimulation.generated.h"
+
+class AFuryShot;
+class AFuryShotInstanceRenderer;
+
+/** a shot waiting to join the simulation, kept with the exact time it was fired */
+struct FPendingFuryShot
+{
+	FVector location;
+	FVector velocity;
+	float gravityScale;
+	float lifetime;
+	float collisionRadius;
+	int damage;
+	TWeakObjectPtr<AActor> shooter;
+	double fireTime;
+};
+
+/**
+ * World subsystem that simulates in-flight Fury Shots as packed arrays instead of one actor per bullet
+ * all shots are moved in a single update and their collision sweeps are issued together as one async batch
+ */
+UCLASS(config=Game)
+class COURSEWORKCODE_API UFuryShotSimulation : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+
+	UFuryShotSimulation();
+
+	virtual void Deinitialize() override;
+
+	// adds a fury shot to the simulation
+	// velocity, gravity, lifespan and collision radius are taken from the defaults of the shot class
+	// the shot joins the simulation on the next update, moved forward to where it would be if fired at fireTime
+	// its first sweep still starts from the muzzle
+	void SpawnShot(TSubclassOf<AFuryShot> shotClass, const FVector& location, const FRotator& rotation, int damageAmount, AActor* shooter, double fireTime);
+
+	// number of shots currently in flight
+	int32 getNumShots() const { return shots.Num(); }
+
+	// FTickableGameObject interface
+	virtual void Tick(float DeltaTime) override;
+	virtual ETickableTickType GetTickableTickType() const override { return ETickableTickType::Conditional; }
+	virtual bool IsTickable() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override { return GetWorld(); }
+	virtual TStatId GetStatId() const override;
+	// End of FTickableGameObject interface
+
+protected:
+
+	/** number of shots above which the movement update is split across worker threads */
+	UPROPERTY(config)
+	int32 parallelUpdateThreshold;
+
+	/** number of shots moved by each worker thread when the update is split */
+	UPROPERTY(config)
+	int32 parallelBatchSize;
+
+	/** collision channel the shot sweeps are traced against */
+	UPROPERTY(config)
+	TEnumAsByte<ECollisionChannel> sweepChannel;
+
+	/** if true every shot is drawn through one instanced mesh, otherwise simulated shots are not drawn */
+	UPROPERTY(config)
+	bool renderWithInstances;
+
+	/** actor that draws the shots, spawned with the first shot */
+	UPROPERTY()
+	AFuryShotInstanceRenderer* instanceRenderer;
+
+	// spawns the instance renderer using the mesh of the given fury shot class
+	void CreateInstanceRenderer(const AFuryShot* shotDefaults);
+
+	// applies the results of last frame's sweeps and removes shots that hit something or expired
+	void ResolveSweeps();
+
+	// moves every shot forward by delta time
+	void IntegrateShots(float DeltaTime);
+
+	// adds the shots fired since the last update, moved forward by the time since each was fired
+	void AddPendingShots();
+
+	// submits one sweep per shot covering the distance it moved this frame
+	void IssueSweeps();
+
+	// packed shot data, one entry per shot in flight
+	FFuryShotSoA shots;
+
+	// shots fired since the last update
+	TArray<FPendingFuryShot> pendingShots;
+
+	// sweep handles from last frame, one per shot that was in flight when they were issued
+	TArray<FTraceHandle> pendingSweeps;
+};
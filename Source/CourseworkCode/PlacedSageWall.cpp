@@ -0,0 +1,367 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "PlacedSageWall.h"
+#include "CourseworkCode.h"
+#include "SageCube.h"
+#include "SageWallNavModifierComponent.h"
+#include "WalkableSurfaceCache.h"
+#include "Components/InstancedStaticMeshComponent.h"
+#include "Curves/CurveFloat.h"
+#include "Engine/CollisionProfile.h"
+#include "Engine/StaticMesh.h"
+#include "Engine/World.h"
+#include "TimerManager.h"
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Sage Wall Segments"), STAT_SageWallSegments, STATGROUP_CourseworkCode);
+DECLARE_CYCLE_STAT(TEXT("Sage Wall Rise"), STAT_SageWallRise, STATGROUP_CourseworkCode);
+
+// Sets default values
+APlacedSageWall::APlacedSageWall()
+{
+	// the wall only ticks while its segments are rising
+	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.bStartWithTickEnabled = false;
+
+	// set up the instanced mesh as the root, every segment is added to it when the wall is built
+	segmentInstances = CreateDefaultSubobject<UInstancedStaticMeshComponent>(TEXT("Segment Instances"));
+	segmentInstances->SetMobility(EComponentMobility::Movable);
+	RootComponent = segmentInstances;
+
+	// the nav modifier marks the segments on the navmesh, so the instanced mesh itself doesn't dirty any navigation
+	segmentInstances->SetCanEverAffectNavigation(false);
+	navModifier = CreateDefaultSubobject<USageWallNavModifierComponent>(TEXT("Nav Modifier"));
+
+	riseDuration = 1.0f;
+	riseCurve = NULL;
+	riseTime = 0.0f;
+
+	resettleDelay = 2.0f;
+	isSettled = false;
+	settleCollisionEnabled = ECollisionEnabled::QueryAndPhysics;
+	settleGenerateOverlaps = true;
+}
+
+// builds the wall out of instances of the sage cube mesh
+void APlacedSageWall::BuildSegments(TSubclassOf<ASageCube> segmentCubeClass, int32 segmentCount, float segmentSpacing, float segmentStartOffset)
+{
+	if (segmentCubeClass == NULL)
+	{
+		return;
+	}
+
+	// copy the look and collision of a sage cube so the wall behaves like one made of cubes
+	const ASageCube* cubeDefaults = segmentCubeClass->GetDefaultObject<ASageCube>();
+	const UStaticMeshComponent* cubeMesh = cubeDefaults->GetCubeStaticMesh();
+
+	segmentInstances->SetStaticMesh(cubeMesh->GetStaticMesh());
+
+	// a custom profile has no name to look up, so its settings are copied over one by one
+	if (cubeMesh->GetCollisionProfileName() == UCollisionProfile::CustomCollisionProfileName)
+	{
+		segmentInstances->SetCollisionObjectType(cubeMesh->GetCollisionObjectType());
+		segmentInstances->SetCollisionEnabled(cubeMesh->GetCollisionEnabled());
+		segmentInstances->SetCollisionResponseToChannels(cubeMesh->GetCollisionResponseToChannels());
+	}
+
+	else
+	{
+		segmentInstances->SetCollisionProfileName(cubeMesh->GetCollisionProfileName());
+	}
+
+	for (int32 materialIndex = 0; materialIndex < cubeMesh->GetNumMaterials(); materialIndex++)
+	{
+		segmentInstances->SetMaterial(materialIndex, cubeMesh->GetMaterial(materialIndex));
+	}
+
+	resettleDelay = cubeDefaults->getResettleDelay();
+
+	USageCubeHealthRegistry* healthRegistry = GetHealthRegistry();
+
+	for (int32 i = 0; i < segmentCount; i++)
+	{
+		// same placement as a cube spawned at the offset along the wall
+		const FTransform segmentTransform = cubeMesh->GetRelativeTransform() * FTransform(FVector(segmentStartOffset + i * segmentSpacing, 0.0f, 0.0f));
+
+		segmentTransforms.Add(segmentTransform);
+		segmentInstances->AddInstance(segmentTransform);
+
+		if (healthRegistry != NULL)
+		{
+			segmentHealth.Add(healthRegistry->Register(cubeDefaults->getStartingHealth(), FOnSageCubeHealthDepleted::CreateUObject(this, &APlacedSageWall::OnSegmentDepleted)));
+		}
+
+		else
+		{
+			segmentHealth.Add(FSageCubeHealthHandle());
+		}
+	}
+
+	INC_DWORD_STAT_BY(STAT_SageWallSegments, segmentCount);
+
+	UpdateNavObstacles();
+	InvalidateWalkableSurface(GetWallBounds());
+
+	// start the segments flat on the ground and raise them over the rise duration
+	riseTime = 0.0f;
+	if (riseDuration > 0.0f)
+	{
+		SetRiseAlpha(0.0f);
+		SetActorTickEnabled(true);
+	}
+
+	// nothing to rise, so the wall settles straight away
+	else
+	{
+		Settle();
+	}
+}
+
+void APlacedSageWall::Settle()
+{
+	GetWorldTimerManager().ClearTimer(settleTimerHandle);
+
+	if (isSettled)
+	{
+		return;
+	}
+
+	settleCollisionEnabled = segmentInstances->GetCollisionEnabled();
+	settleGenerateOverlaps = segmentInstances->GetGenerateOverlapEvents();
+
+	ASageCube::SetSettledState(segmentInstances, segmentInstances, true, settleCollisionEnabled, settleGenerateOverlaps);
+	isSettled = true;
+}
+
+void APlacedSageWall::WakeFromSettled()
+{
+	if (!isSettled)
+	{
+		return;
+	}
+
+	ASageCube::SetSettledState(segmentInstances, segmentInstances, false, settleCollisionEnabled, settleGenerateOverlaps);
+	isSettled = false;
+}
+
+FSageCubeHealthHandle APlacedSageWall::GetSegmentHealthHandle(int32 instanceIndex) const
+{
+	return segmentHealth.IsValidIndex(instanceIndex) ? segmentHealth[instanceIndex] : FSageCubeHealthHandle();
+}
+
+// the impact point is tested against each segment's full size box in the wall's space
+// the hit item is tried first since it is almost always still right
+int32 APlacedSageWall::FindHitInstance(int32 hitItem, const FVector& impactPoint) const
+{
+	UStaticMesh* segmentMesh = segmentInstances->GetStaticMesh();
+	if (segmentMesh == NULL)
+	{
+		return INDEX_NONE;
+	}
+
+	const FBox meshBox = segmentMesh->GetBoundingBox();
+	const FVector localPoint = segmentInstances->GetComponentTransform().InverseTransformPosition(impactPoint);
+
+	// impact points sit on the surface, so the boxes are grown slightly to catch them
+	auto isPointOnSegment = [this, &meshBox, &localPoint](int32 instanceIndex)
+	{
+		return meshBox.TransformBy(segmentTransforms[instanceIndex]).ExpandBy(1.0f).IsInsideOrOn(localPoint);
+	};
+
+	if (segmentTransforms.IsValidIndex(hitItem) && isPointOnSegment(hitItem))
+	{
+		return hitItem;
+	}
+
+	for (int32 instanceIndex = 0; instanceIndex < segmentTransforms.Num(); instanceIndex++)
+	{
+		if (instanceIndex != hitItem && isPointOnSegment(instanceIndex))
+		{
+			return instanceIndex;
+		}
+	}
+
+	return INDEX_NONE;
+}
+
+// damages a single segment through the health registry
+// a settled wall goes back to the dynamic state, and settles again once it hasn't been hit for a while
+bool APlacedSageWall::ApplySegmentDamage(const FSageCubeHealthHandle& segmentHandle, int damageAmount)
+{
+	// a wall still waiting to settle after earlier damage starts the wait again
+	if (isSettled || settleTimerHandle.IsValid())
+	{
+		WakeFromSettled();
+		GetWorldTimerManager().SetTimer(settleTimerHandle, this, &APlacedSageWall::Settle, FMath::Max(resettleDelay, 0.01f), false);
+	}
+
+	USageCubeHealthRegistry* healthRegistry = GetHealthRegistry();
+
+	return healthRegistry != NULL && healthRegistry->ApplyDamage(segmentHandle, damageAmount);
+}
+
+// removes the segment whose health ran out, and the whole wall once no segments are left
+void APlacedSageWall::OnSegmentDepleted(FSageCubeHealthHandle depletedHandle)
+{
+	const int32 instanceIndex = segmentHealth.IndexOfByPredicate([&depletedHandle](const FSageCubeHealthHandle& handle)
+	{
+		return handle == depletedHandle;
+	});
+
+	if (instanceIndex == INDEX_NONE)
+	{
+		return;
+	}
+
+	GetHealthRegistry()->Unregister(segmentHealth[instanceIndex]);
+	InvalidateWalkableSurface(GetSegmentBounds(instanceIndex));
+
+	// removing an instance moves every later instance down by one, so the segment arrays are kept in step
+	segmentHealth.RemoveAt(instanceIndex);
+	segmentTransforms.RemoveAt(instanceIndex);
+	segmentInstances->RemoveInstance(instanceIndex);
+
+	DEC_DWORD_STAT(STAT_SageWallSegments);
+
+	if (segmentHealth.Num() == 0)
+	{
+		Destroy();
+	}
+
+	// only the removed segment's tiles change
+	else
+	{
+		UpdateNavObstacles();
+	}
+}
+
+// the boxes are the full size segments, so bots path around a wall that is still rising
+void APlacedSageWall::UpdateNavObstacles()
+{
+	UStaticMesh* segmentMesh = segmentInstances->GetStaticMesh();
+	if (segmentMesh == NULL)
+	{
+		return;
+	}
+
+	const FTransform& wallTransform = segmentInstances->GetComponentTransform();
+
+	TArray<FTransform> segmentToWorld;
+	segmentToWorld.Reserve(segmentTransforms.Num());
+
+	for (const FTransform& segmentTransform : segmentTransforms)
+	{
+		segmentToWorld.Add(segmentTransform * wallTransform);
+	}
+
+	navModifier->SetObstacles(segmentMesh->GetBoundingBox(), segmentToWorld);
+}
+
+// scales every segment on the Z-Axis, the same way the sage cube rises from the ground
+void APlacedSageWall::SetRiseAlpha(float riseAlpha)
+{
+	// never scale all the way to zero so the segment collision stays valid
+	const float heightScale = FMath::Max(riseAlpha, 0.01f);
+
+	risingTransforms.Reset();
+	for (const FTransform& segmentTransform : segmentTransforms)
+	{
+		FTransform risingTransform = segmentTransform;
+		risingTransform.SetScale3D(segmentTransform.GetScale3D() * FVector(1.0f, 1.0f, heightScale));
+
+		risingTransforms.Add(risingTransform);
+	}
+
+	// every segment is moved in one batch
+	if (risingTransforms.Num() > 0)
+	{
+		segmentInstances->BatchUpdateInstancesTransforms(0, risingTransforms, false, true, true);
+	}
+}
+
+USageCubeHealthRegistry* APlacedSageWall::GetHealthRegistry() const
+{
+	UWorld* const World = GetWorld();
+
+	return World != NULL ? World->GetSubsystem<USageCubeHealthRegistry>() : NULL;
+}
+
+FBox APlacedSageWall::GetSegmentBounds(int32 instanceIndex) const
+{
+	const UStaticMesh* segmentMesh = segmentInstances->GetStaticMesh();
+	if (segmentMesh == NULL || !segmentTransforms.IsValidIndex(instanceIndex))
+	{
+		return FBox(ForceInit);
+	}
+
+	return segmentMesh->GetBoundingBox().TransformBy(segmentTransforms[instanceIndex] * segmentInstances->GetComponentTransform());
+}
+
+FBox APlacedSageWall::GetWallBounds() const
+{
+	FBox wallBounds(ForceInit);
+	for (int32 i = 0; i < segmentTransforms.Num(); i++)
+	{
+		wallBounds += GetSegmentBounds(i);
+	}
+
+	return wallBounds;
+}
+
+// the segments can be the ground another wall is placed on, so the cells under them change when they are placed or removed
+void APlacedSageWall::InvalidateWalkableSurface(const FBox& area) const
+{
+	UWorld* const World = GetWorld();
+	UWalkableSurfaceCache* surfaceCache = World != NULL ? World->GetSubsystem<UWalkableSurfaceCache>() : NULL;
+
+	if (surfaceCache != NULL && area.IsValid)
+	{
+		surfaceCache->InvalidateArea(area);
+	}
+}
+
+void APlacedSageWall::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	GetWorldTimerManager().ClearTimer(settleTimerHandle);
+	WakeFromSettled();
+	InvalidateWalkableSurface(GetWallBounds());
+
+	USageCubeHealthRegistry* healthRegistry = GetHealthRegistry();
+	if (healthRegistry != NULL)
+	{
+		for (FSageCubeHealthHandle& handle : segmentHealth)
+		{
+			healthRegistry->Unregister(handle);
+		}
+	}
+
+	DEC_DWORD_STAT_BY(STAT_SageWallSegments, segmentHealth.Num());
+	segmentHealth.Empty();
+
+	Super::EndPlay(EndPlayReason);
+}
+
+// Called every frame
+void APlacedSageWall::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	SCOPE_CYCLE_COUNTER(STAT_SageWallRise);
+
+	riseTime = FMath::Min(riseTime + DeltaTime, riseDuration);
+
+	float riseAlpha = riseDuration > 0.0f ? riseTime / riseDuration : 1.0f;
+	if (riseCurve != NULL)
+	{
+		riseAlpha = riseCurve->GetFloatValue(riseAlpha);
+	}
+
+	SetRiseAlpha(riseAlpha);
+
+	// nothing left to do once the segments are fully raised
+	if (riseTime >= riseDuration)
+	{
+		SetActorTickEnabled(false);
+		Settle();
+	}
+}
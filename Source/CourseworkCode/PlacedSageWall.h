@@ -0,0 +1,127 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "SageCubeHealthRegistry.h"
+#include "PlacedSageWall.generated.h"
+
+class ASageCube;
+class UCurveFloat;
+class UInstancedStaticMeshComponent;
+class USageWallNavModifierComponent;
+
+/**
+ * A placed Sage Wall, every segment is one instance of a single instanced static mesh component
+ * each segment has its own collision and its own entry in the sage cube health registry
+ * so a wall of any length is one actor and one draw proxy
+ */
+UCLASS()
+class COURSEWORKCODE_API APlacedSageWall : public AActor
+{
+	GENERATED_BODY()
+
+public:
+	// Sets default values for this actor's properties
+	APlacedSageWall();
+
+	// adds one segment per cube along the wall's X axis, starting at the start offset
+	// mesh, material, scale and health are taken from the defaults of the sage cube class
+	void BuildSegments(TSubclassOf<ASageCube> segmentCubeClass, int32 segmentCount, float segmentSpacing, float segmentStartOffset);
+
+	// gets the health registry entry of the segment drawn by the given instance
+	// instance indices change when a segment is removed, the handle doesn't
+	FSageCubeHealthHandle GetSegmentHealthHandle(int32 instanceIndex) const;
+
+	// finds the instance a hit landed on, checking the hit item against the impact point first
+	// the hit item can point at the wrong instance if segments were removed after the sweep that found it
+	// returns INDEX_NONE if no standing segment is at the impact point
+	int32 FindHitInstance(int32 hitItem, const FVector& impactPoint) const;
+
+	// takes damage away from the segment's health, waking the wall up if it has settled
+	// returns true if this damage destroyed the segment
+	bool ApplySegmentDamage(const FSageCubeHealthHandle& segmentHandle, int damageAmount);
+
+	// number of segments still standing
+	int32 getNumSegments() const { return segmentHealth.Num(); }
+
+protected:
+
+	/** instanced mesh component drawing every segment of the wall */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
+	UInstancedStaticMeshComponent* segmentInstances;
+
+	/** cuts the standing segments out of the navmesh */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
+	USageWallNavModifierComponent* navModifier;
+
+	/** time in seconds the segments take to rise out of the ground */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	float riseDuration;
+
+	/** optional curve mapping rise time to height, from 0 to 1, a straight line is used if not set */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	UCurveFloat* riseCurve;
+
+	// health registry entry of each segment, in the same order as the instances
+	TArray<FSageCubeHealthHandle> segmentHealth;
+
+	// full size transform of each segment, in the same order as the instances
+	TArray<FTransform> segmentTransforms;
+
+	// segment transforms scaled to the current rise height, kept between frames to avoid reallocating
+	TArray<FTransform> risingTransforms;
+
+	// time the segments have been rising for
+	float riseTime;
+
+	// time a damaged wall waits before settling again, taken from the sage cube class
+	float resettleDelay;
+
+	// true once the wall has risen and switched to the settled state
+	bool isSettled;
+
+	// collision and overlap settings the segments had before the wall settled
+	TEnumAsByte<ECollisionEnabled::Type> settleCollisionEnabled;
+	bool settleGenerateOverlaps;
+
+	// settles the wall again a while after it was last damaged
+	FTimerHandle settleTimerHandle;
+
+	// switches the wall into the settled state once it has fully risen
+	void Settle();
+
+	// switches the wall back to the dynamic state
+	void WakeFromSettled();
+
+	// called by the health registry once a segment's health runs out
+	void OnSegmentDepleted(FSageCubeHealthHandle depletedHandle);
+
+	// updates the navmesh boxes to cover the segments still standing
+	void UpdateNavObstacles();
+
+	// sets the height of every segment to the given fraction of its full height
+	void SetRiseAlpha(float riseAlpha);
+
+	// gets the health registry of the wall's world
+	USageCubeHealthRegistry* GetHealthRegistry() const;
+
+	// world space box of the full size segment
+	FBox GetSegmentBounds(int32 instanceIndex) const;
+
+	// makes the walkable surface cache trace the ground in the area again
+	void InvalidateWalkableSurface(const FBox& area) const;
+
+	// world space box of every standing segment
+	FBox GetWallBounds() const;
+
+protected:
+	// removes every segment from the health registry
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+public:
+	// raises the segments, ticking stops once they are fully raised
+	virtual void Tick(float DeltaTime) override;
+
+};
@@ -2,14 +2,21 @@
 
 
 #include "SageCube.h"
+#include "CourseworkCode.h"
+#include "WalkableSurfaceCache.h"
 #include "Engine/StaticMesh.h"
+#include "Engine/World.h"
 #include "Runtime/CoreUObject/Public/UObject/ConstructorHelpers.h"
+#include "Components/TimelineComponent.h"
+#include "TimerManager.h"
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Settled Sage Wall Pieces"), STAT_SettledSageWallPieces, STATGROUP_CourseworkCode);
 
 // Sets default values
 ASageCube::ASageCube()
 {
- 	// Set this actor to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
-	PrimaryActorTick.bCanEverTick = true;
+ 	// sage cubes never tick, the health registry calls the cube back when its health runs out
+	PrimaryActorTick.bCanEverTick = false;
 
 	// sets the scene component as root component for the actor to use within the world and blueprints
 	cubeSceneComp = CreateDefaultSubobject<USceneComponent>(TEXT("Cube Scene"));
@@ -32,8 +39,18 @@ ASageCube::ASageCube()
 		
 	}
 
+	// the "SageWall" object type, so flashes and the walkable surface cache can find placed walls without tracing everything that moves
+	// placed walls drawn as instances copy this profile from the cube
+	cubeStaticMesh->SetCollisionProfileName(TEXT("SageWall"));
+
 	// set initial health value
 	cubeHealth = 500;
+
+	// these can be overridden in DefaultGame.ini
+	resettleDelay = 2.0f;
+	isSettled = false;
+	settleCollisionEnabled = ECollisionEnabled::QueryAndPhysics;
+	settleGenerateOverlaps = true;
 }
 
 
@@ -48,39 +65,203 @@ void ASageCube::RaiseCubeFromGround(const float & changeZValue)
 	// sets new scale values with the z-value coming from a timeline within the blueprints
 	cubeStaticMesh->SetRelativeScale3D(FVector(currentScale.X, currentScale.Y, changeZValue));
 
+	// the timeline has reached the cube's full height, so the rise is over
+	if (changeZValue >= GetClass()->GetDefaultObject<ASageCube>()->GetCubeStaticMesh()->GetRelativeScale3D().Z)
+	{
+		Settle();
+	}
 }
 
 // gets the health of the cube
 int ASageCube::getCubeHealth()
 {
-	return cubeHealth;
+	USageCubeHealthRegistry* healthRegistry = GetHealthRegistry();
+
+	return healthRegistry != NULL && healthRegistry->IsRegistered(healthHandle) ? healthRegistry->GetHealth(healthHandle) : cubeHealth;
 }
 
 // sets the health of the cube
 void ASageCube::setCubeHealth(int val)
 {
-	cubeHealth = val;
+	USageCubeHealthRegistry* healthRegistry = GetHealthRegistry();
+
+	if (healthRegistry != NULL && healthRegistry->IsRegistered(healthHandle))
+	{
+		healthRegistry->SetHealth(healthHandle, val);
+	}
+}
+
+// damages the cube through the health registry
+// a settled cube goes back to the dynamic state, and settles again once it hasn't been hit for a while
+bool ASageCube::ApplyCubeDamage(int damageAmount)
+{
+	// a cube still waiting to settle after earlier damage starts the wait again
+	if (isSettled || settleTimerHandle.IsValid())
+	{
+		WakeFromSettled();
+		GetWorldTimerManager().SetTimer(settleTimerHandle, this, &ASageCube::Settle, FMath::Max(resettleDelay, 0.01f), false);
+	}
+
+	USageCubeHealthRegistry* healthRegistry = GetHealthRegistry();
+
+	return healthRegistry != NULL && healthRegistry->ApplyDamage(healthHandle, damageAmount);
+}
+
+// destroy the cube once its health reaches 0
+void ASageCube::OnHealthDepleted(FSageCubeHealthHandle depletedHandle)
+{
+	UAbilityActorPool::ReleaseOrDestroy(this);
+}
+
+USageCubeHealthRegistry* ASageCube::GetHealthRegistry() const
+{
+	UWorld* const World = GetWorld();
+
+	return World != NULL ? World->GetSubsystem<USageCubeHealthRegistry>() : NULL;
+}
+
+// the cube can be the ground another wall is placed on, so the cells under it change when it is placed or removed
+void ASageCube::InvalidateWalkableSurface() const
+{
+	UWorld* const World = GetWorld();
+	UWalkableSurfaceCache* surfaceCache = World != NULL ? World->GetSubsystem<UWalkableSurfaceCache>() : NULL;
+
+	if (surfaceCache != NULL)
+	{
+		surfaceCache->InvalidateArea(cubeStaticMesh->Bounds.GetBox());
+	}
+}
+
+void ASageCube::SetSettledState(USceneComponent* root, UPrimitiveComponent* mesh, bool settled, ECollisionEnabled::Type dynamicCollision, bool dynamicOverlaps)
+{
+	if (settled)
+	{
+		// projectiles only sweep against the piece, so no physics body or overlaps are needed
+		mesh->SetGenerateOverlapEvents(false);
+		mesh->SetCollisionEnabled(ECollisionEnabled::QueryOnly);
+
+		// stationary pieces don't move, so the renderer can cache their shadows instead of redrawing them every frame
+		root->SetMobility(EComponentMobility::Stationary);
+		mesh->SetMobility(EComponentMobility::Stationary);
+
+		INC_DWORD_STAT(STAT_SettledSageWallPieces);
+	}
+
+	else
+	{
+		// setting the root back to movable sets every child back to movable too
+		root->SetMobility(EComponentMobility::Movable);
+		mesh->SetMobility(EComponentMobility::Movable);
+
+		mesh->SetCollisionEnabled(dynamicCollision);
+		mesh->SetGenerateOverlapEvents(dynamicOverlaps);
+
+		DEC_DWORD_STAT(STAT_SettledSageWallPieces);
+	}
+}
+
+void ASageCube::Settle()
+{
+	GetWorldTimerManager().ClearTimer(settleTimerHandle);
+
+	if (isSettled)
+	{
+		return;
+	}
+
+	// the rise timelines have nothing left to play
+	TInlineComponentArray<UTimelineComponent*> timelines;
+	GetComponents(timelines);
+
+	for (UTimelineComponent* timeline : timelines)
+	{
+		timeline->Stop();
+		timeline->SetComponentTickEnabled(false);
+	}
+
+	settleCollisionEnabled = cubeStaticMesh->GetCollisionEnabled();
+	settleGenerateOverlaps = cubeStaticMesh->GetGenerateOverlapEvents();
+
+	SetSettledState(RootComponent, cubeStaticMesh, true, settleCollisionEnabled, settleGenerateOverlaps);
+	isSettled = true;
+}
+
+void ASageCube::WakeFromSettled()
+{
+	if (!isSettled)
+	{
+		return;
+	}
+
+	SetSettledState(RootComponent, cubeStaticMesh, false, settleCollisionEnabled, settleGenerateOverlaps);
+	isSettled = false;
+}
+
+// resets the cube so it rises from the ground like a freshly spawned one
+void ASageCube::OnAcquiredFromPool()
+{
+	// restore the starting health of the cube
+	setCubeHealth(cubeHealth);
+
+	InvalidateWalkableSurface();
+
+	// the blueprint raise timeline only auto plays on begin play
+	// so restart it here to raise the cube again
+	TInlineComponentArray<UTimelineComponent*> timelines;
+	GetComponents(timelines);
+
+	for (UTimelineComponent* timeline : timelines)
+	{
+		timeline->SetComponentTickEnabled(true);
+		timeline->PlayFromStart();
+	}
+}
+
+// stops the raise timeline while the cube is inside the pool
+void ASageCube::OnReleasedToPool()
+{
+	TInlineComponentArray<UTimelineComponent*> timelines;
+	GetComponents(timelines);
+
+	for (UTimelineComponent* timeline : timelines)
+	{
+		timeline->Stop();
+	}
+
+	// put the mobility back so the pool can move the cube
+	GetWorldTimerManager().ClearTimer(settleTimerHandle);
+	WakeFromSettled();
+
+	InvalidateWalkableSurface();
 }
 
 // Called when the game starts or when spawned
 void ASageCube::BeginPlay()
 {
 	Super::BeginPlay();
-	
 
+	// keep the cube's health in the registry so damage doesn't need the cube to tick
+	USageCubeHealthRegistry* healthRegistry = GetHealthRegistry();
+	if (healthRegistry != NULL)
+	{
+		healthHandle = healthRegistry->Register(cubeHealth, FOnSageCubeHealthDepleted::CreateUObject(this, &ASageCube::OnHealthDepleted));
+	}
 
+	InvalidateWalkableSurface();
 }
 
-// Called every frame
-void ASageCube::Tick(float DeltaTime)
+void ASageCube::EndPlay(const EEndPlayReason::Type EndPlayReason)
 {
-	Super::Tick(DeltaTime);
+	GetWorldTimerManager().ClearTimer(settleTimerHandle);
 
-	// destroy the cube if its health reaches below 0
-	if (cubeHealth <= 0)
+	WakeFromSettled();
+	InvalidateWalkableSurface();
+
+	USageCubeHealthRegistry* healthRegistry = GetHealthRegistry();
+	if (healthRegistry != NULL)
 	{
-		Destroy();
+		healthRegistry->Unregister(healthHandle);
 	}
 
+	Super::EndPlay(EndPlayReason);
 }
-
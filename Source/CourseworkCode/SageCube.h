@@ -6,10 +6,12 @@
 #include "Components/SceneComponent.h"
 #include "Components/StaticMeshComponent.h"
 #include "GameFramework/Actor.h"
+#include "AbilityActorPool.h"
+#include "SageCubeHealthRegistry.h"
 #include "SageCube.generated.h"
 
-UCLASS()
-class COURSEWORKCODE_API ASageCube : public AActor
+UCLASS(config=Game)
+class COURSEWORKCODE_API ASageCube : public AActor, public IPooledAbilityActor
 {
 	GENERATED_BODY()
 	
@@ -33,6 +35,31 @@ public:
 	UFUNCTION()
 		void setCubeHealth(int val);
 
+	// gets the health the cube starts with
+	int getStartingHealth() const { return cubeHealth; }
+
+	/** Returns cubeStaticMesh subobject **/
+	FORCEINLINE UStaticMeshComponent* GetCubeStaticMesh() const { return cubeStaticMesh; }
+
+	// switches a risen wall piece between the settled state and the dynamic state it rises and takes damage in
+	// settled pieces don't generate overlaps, only answer queries and are stationary so their shadows can be cached
+	// the dynamic collision and overlap settings are put back when the piece leaves the settled state
+	static void SetSettledState(USceneComponent* root, UPrimitiveComponent* mesh, bool settled, ECollisionEnabled::Type dynamicCollision, bool dynamicOverlaps);
+
+	// time a damaged piece waits before settling again
+	float getResettleDelay() const { return resettleDelay; }
+
+	// takes damage away from the cube's health
+	// returns true if this damage destroyed the cube
+	bool ApplyCubeDamage(int damageAmount);
+
+	// pool reset hooks
+	// restores full health and raises the cube again when placed
+	virtual void OnAcquiredFromPool() override;
+
+	// stops the raise animation while the cube waits in the pool
+	virtual void OnReleasedToPool() override;
+
 protected:
 
 	/** sets static mesh component for the cube */
@@ -43,16 +70,47 @@ protected:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite)
 		USceneComponent* cubeSceneComp;
 
-	/** health integer value used to determine health of cube */
+	/** health integer value the cube starts with, the current health is kept in the sage cube health registry */
 	UPROPERTY(EditAnywhere, BlueprintReadWrite)
 		int cubeHealth;
 
+	/** time in seconds a damaged cube waits before settling again */
+	UPROPERTY(config, EditAnywhere, BlueprintReadOnly)
+		float resettleDelay;
+
+	// entry in the sage cube health registry holding the current health
+	FSageCubeHealthHandle healthHandle;
+
+	// true once the cube has risen and switched to the settled state
+	bool isSettled;
+
+	// collision and overlap settings the cube had before it settled
+	TEnumAsByte<ECollisionEnabled::Type> settleCollisionEnabled;
+	bool settleGenerateOverlaps;
+
+	// settles the cube again a while after it was last damaged
+	FTimerHandle settleTimerHandle;
+
+	// switches the cube into the settled state once it has fully risen
+	void Settle();
+
+	// switches the cube back to the dynamic state
+	void WakeFromSettled();
+
+	// called by the health registry once the cube's health runs out
+	void OnHealthDepleted(FSageCubeHealthHandle depletedHandle);
+
+	// gets the health registry of the cube's world
+	USageCubeHealthRegistry* GetHealthRegistry() const;
+
+	// makes the walkable surface cache trace the ground under the cube again
+	void InvalidateWalkableSurface() const;
+
 protected:
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
 
-public:	
-	// Called every frame
-	virtual void Tick(float DeltaTime) override;
+	// removes the cube's entry from the health registry
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 
 };
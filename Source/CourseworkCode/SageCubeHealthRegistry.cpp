@@ -0,0 +1,151 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "SageCubeHealthRegistry.h"
+#include "CourseworkCode.h"
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Sage Cube Health Entries"), STAT_SageCubeHealthEntries, STATGROUP_CourseworkCode);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Sage Cube Damage Applied"), STAT_SageCubeDamageApplied, STATGROUP_CourseworkCode);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Sage Cubes Depleted"), STAT_SageCubesDepleted, STATGROUP_CourseworkCode);
+
+void USageCubeHealthRegistry::Deinitialize()
+{
+	DEC_DWORD_STAT_BY(STAT_SageCubeHealthEntries, health.Num());
+
+	slots.Empty();
+	freeSlots.Empty();
+	health.Empty();
+	depletedDelegates.Empty();
+	denseToSlot.Empty();
+
+	Super::Deinitialize();
+}
+
+FSageCubeHealthHandle USageCubeHealthRegistry::Register(int32 initialHealth, const FOnSageCubeHealthDepleted& onDepleted)
+{
+	// reuse a free slot if there is one
+	int32 slotIndex;
+	if (freeSlots.Num() > 0)
+	{
+		slotIndex = freeSlots.Pop(false);
+	}
+
+	else
+	{
+		slotIndex = slots.Add({ INDEX_NONE, 0 });
+	}
+
+	FHealthSlot& slot = slots[slotIndex];
+	slot.denseIndex = health.Add(initialHealth);
+	depletedDelegates.Add(onDepleted);
+	denseToSlot.Add(slotIndex);
+
+	INC_DWORD_STAT(STAT_SageCubeHealthEntries);
+
+	FSageCubeHealthHandle handle;
+	handle.index = slotIndex;
+	handle.generation = slot.generation;
+
+	return handle;
+}
+
+void USageCubeHealthRegistry::Unregister(FSageCubeHealthHandle& handle)
+{
+	const int32 denseIndex = GetDenseIndex(handle);
+
+	if (denseIndex != INDEX_NONE)
+	{
+		// the last entry is moved into the gap, so its slot has to point at its new position
+		const int32 lastDenseIndex = health.Num() - 1;
+		if (denseIndex != lastDenseIndex)
+		{
+			slots[denseToSlot[lastDenseIndex]].denseIndex = denseIndex;
+		}
+
+		health.RemoveAtSwap(denseIndex, 1, false);
+		depletedDelegates.RemoveAtSwap(denseIndex, 1, false);
+		denseToSlot.RemoveAtSwap(denseIndex, 1, false);
+
+		// bumping the generation stops any copies of the handle from finding the next entry in this slot
+		FHealthSlot& slot = slots[handle.index];
+		slot.denseIndex = INDEX_NONE;
+		slot.generation++;
+		freeSlots.Add(handle.index);
+
+		DEC_DWORD_STAT(STAT_SageCubeHealthEntries);
+	}
+
+	handle.Invalidate();
+}
+
+bool USageCubeHealthRegistry::IsRegistered(const FSageCubeHealthHandle& handle) const
+{
+	return GetDenseIndex(handle) != INDEX_NONE;
+}
+
+int32 USageCubeHealthRegistry::GetHealth(const FSageCubeHealthHandle& handle) const
+{
+	const int32 denseIndex = GetDenseIndex(handle);
+
+	return denseIndex != INDEX_NONE ? health[denseIndex] : 0;
+}
+
+void USageCubeHealthRegistry::SetHealth(const FSageCubeHealthHandle& handle, int32 newHealth)
+{
+	const int32 denseIndex = GetDenseIndex(handle);
+
+	if (denseIndex != INDEX_NONE)
+	{
+		ChangeHealth(denseIndex, newHealth);
+	}
+}
+
+bool USageCubeHealthRegistry::ApplyDamage(const FSageCubeHealthHandle& handle, int32 damageAmount)
+{
+	const int32 denseIndex = GetDenseIndex(handle);
+
+	if (denseIndex == INDEX_NONE)
+	{
+		return false;
+	}
+
+	INC_DWORD_STAT(STAT_SageCubeDamageApplied);
+
+	return ChangeHealth(denseIndex, health[denseIndex] - damageAmount);
+}
+
+int32 USageCubeHealthRegistry::GetDenseIndex(const FSageCubeHealthHandle& handle) const
+{
+	if (!slots.IsValidIndex(handle.index) || slots[handle.index].generation != handle.generation)
+	{
+		return INDEX_NONE;
+	}
+
+	return slots[handle.index].denseIndex;
+}
+
+// only the change from above 0 to 0 or below calls the delegate
+// more damage to an entry that has already run out does nothing
+bool USageCubeHealthRegistry::ChangeHealth(int32 denseIndex, int32 newHealth)
+{
+	const bool wasAlive = health[denseIndex] > 0;
+	health[denseIndex] = newHealth;
+
+	if (!wasAlive || newHealth > 0)
+	{
+		return false;
+	}
+
+	INC_DWORD_STAT(STAT_SageCubesDepleted);
+
+	// copy the delegate and handle first, the owner is likely to unregister the entry from inside the callback
+	const FOnSageCubeHealthDepleted onDepleted = depletedDelegates[denseIndex];
+
+	FSageCubeHealthHandle handle;
+	handle.index = denseToSlot[denseIndex];
+	handle.generation = slots[handle.index].generation;
+
+	onDepleted.ExecuteIfBound(handle);
+
+	return true;
+}
@@ -0,0 +1,93 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "SageCubeHealthRegistry.generated.h"
+
+/** refers to one health entry in the registry, a handle to a removed entry is never valid again */
+struct FSageCubeHealthHandle
+{
+	FSageCubeHealthHandle() : index(INDEX_NONE), generation(0) {}
+
+	bool IsValid() const { return index != INDEX_NONE; }
+
+	void Invalidate() { index = INDEX_NONE; }
+
+	bool operator==(const FSageCubeHealthHandle& other) const { return index == other.index && generation == other.generation; }
+
+	// slot in the registry
+	int32 index;
+
+	// bumped every time the slot is reused, so old handles to it stop working
+	uint32 generation;
+};
+
+// called once when an entry's health drops from above 0 to 0 or below
+DECLARE_DELEGATE_OneParam(FOnSageCubeHealthDepleted, FSageCubeHealthHandle);
+
+/**
+ * World subsystem that stores the health of every Sage Cube in one packed array
+ * damage is applied through the registry, which calls the owner back only when health runs out
+ * so cubes don't have to tick to check their own health
+ */
+UCLASS()
+class COURSEWORKCODE_API USageCubeHealthRegistry : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	virtual void Deinitialize() override;
+
+	// adds a health entry and returns its handle
+	// the delegate is called when the health of the entry runs out
+	FSageCubeHealthHandle Register(int32 initialHealth, const FOnSageCubeHealthDepleted& onDepleted);
+
+	// removes the entry, the last entry is moved into its place to keep the health array packed
+	void Unregister(FSageCubeHealthHandle& handle);
+
+	// true if the handle still refers to an entry
+	bool IsRegistered(const FSageCubeHealthHandle& handle) const;
+
+	// returns the current health, or 0 if the handle isn't registered
+	int32 GetHealth(const FSageCubeHealthHandle& handle) const;
+
+	// sets the health straight away, calls the depleted delegate if this takes the health down to 0
+	void SetHealth(const FSageCubeHealthHandle& handle, int32 newHealth);
+
+	// takes damage away from the entry's health
+	// returns true if this damage took the health down to 0, which also calls the depleted delegate
+	bool ApplyDamage(const FSageCubeHealthHandle& handle, int32 damageAmount);
+
+	// number of registered entries
+	int32 getNumEntries() const { return health.Num(); }
+
+protected:
+
+	// finds the position of the handle's entry in the packed arrays, or INDEX_NONE
+	int32 GetDenseIndex(const FSageCubeHealthHandle& handle) const;
+
+	// changes the health and calls the depleted delegate on the transition to 0
+	// returns true if the delegate was called
+	bool ChangeHealth(int32 denseIndex, int32 newHealth);
+
+	/** handle slot, points at the entry in the packed arrays */
+	struct FHealthSlot
+	{
+		int32 denseIndex;
+		uint32 generation;
+	};
+
+	// one slot per handle ever given out, reused through the free list
+	TArray<FHealthSlot> slots;
+	TArray<int32> freeSlots;
+
+	// packed entry data, one element per registered entry
+	TArray<int32> health;
+	TArray<FOnSageCubeHealthDepleted> depletedDelegates;
+
+	// slot of each packed entry, used to fix up the slot when an entry is moved
+	TArray<int32> denseToSlot;
+};
@@ -4,16 +4,32 @@
 #include "SageWall.h"
 #include "CourseworkCodeCharacter.h"
 #include "SageCube.h"
+#include "PlacedSageWall.h"
+#include "AbilityActorPool.h"
+#include "WalkableSurfaceCache.h"
+#include "CourseworkCodeTestWorld.h"
 #include "Engine/StaticMesh.h"
 #include "Materials/Material.h"
 #include "Runtime/CoreUObject/Public/UObject/ConstructorHelpers.h"
 #include "Camera/CameraComponent.h"
 #include "GameFramework/Pawn.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "GameFramework/PlayerController.h"
 #include "Engine/Engine.h"
 #include "Engine/World.h"
 #include "DrawDebugHelpers.h"
 #include "Kismet/KismetMathLibrary.h"
 #include "Runtime/Engine/Classes/Kismet/GameplayStatics.h"
+#include "CourseworkCode.h"
+#include "Components/BoxComponent.h"
+#include "Engine/CollisionProfile.h"
+#include "Misc/AutomationTest.h"
+
+DECLARE_CYCLE_STAT(TEXT("Sage Wall Placement Trace"), STAT_SageWallPlacementTrace, STATGROUP_CourseworkCode);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Sage Wall Axis Bindings"), STAT_SageWallAxisBindings, STATGROUP_CourseworkCode);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Sage Wall Placement Reused"), STAT_SageWallPlacementReused, STATGROUP_CourseworkCode);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Sage Wall Placement Evaluated"), STAT_SageWallPlacementEvaluated, STATGROUP_CourseworkCode);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Sage Wall Placement Reuse Rate %"), STAT_SageWallPlacementReuseRate, STATGROUP_CourseworkCode);
 
 // Sets default values
 ASageWall::ASageWall()
@@ -54,6 +70,33 @@ ASageWall::ASageWall()
 	changeInRotation = 0.0f;
 	defaultRotation = 90.0f;
 	turnAxisVal = 0.0f;
+
+	// three segments with a small gap between each of them
+	// these can be overridden in DefaultGame.ini
+	useInstancedSegments = true;
+	segmentCount = 3;
+	segmentSpacing = 201.0f;
+	segmentStartOffset = -1.0f;
+	footprintSamplesPerSegment = 3;
+	PlacedSageWallClass = APlacedSageWall::StaticClass();
+
+	// the placement trace never blocks the game thread by default
+	placementTraceMode = ESageWallTraceMode::Async;
+	hasPlacementHit = false;
+	previewInterpSpeed = 0.0f;
+	previewLocation = FVector::ZeroVector;
+	hasPreviewLocation = false;
+
+	// placement is only worked out again once the camera or rotation input moves past these
+	placementLocationEpsilon = 1.0f;
+	placementRotationEpsilon = 0.1f;
+	placementTurnEpsilon = 0.001f;
+	lastCameraLocation = FVector::ZeroVector;
+	lastCameraRotation = FRotator::ZeroRotator;
+	lastTurnAxisVal = 0.0f;
+	isPlacementSettled = false;
+	placementCacheHits = 0;
+	placementCacheMisses = 0;
 }
 
 
@@ -82,8 +125,9 @@ void ASageWall::SpawnSageCube(const FVector FinalLoc, const FRotator FinalRot, F
 			FActorSpawnParameters SageWallSpawnParams;
 			SageWallSpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
 
-			// spawn the sage cube at the given location and rotation
-			World->SpawnActor<ASageCube>(SageCubeClass, finalCubeLoc, FinalRot, SageWallSpawnParams);
+			// take a sage cube from the pool and place it at the given location and rotation
+			UAbilityActorPool* pool = World->GetSubsystem<UAbilityActorPool>();
+			pool->Acquire<ASageCube>(SageCubeClass, FTransform(FinalRot, finalCubeLoc), SageWallSpawnParams);
 		}
 	}
 
@@ -95,11 +139,80 @@ void ASageWall::SpawnSageCube(const FVector FinalLoc, const FRotator FinalRot, F
 
 }
 
+// spawns every segment of the wall in one go
+void ASageWall::SpawnWallSegments(const FVector FinalLoc, const FRotator FinalRot)
+{
+	UWorld* const World = GetWorld();
+	if (World == NULL)
+	{
+		return;
+	}
+
+	if (useInstancedSegments && PlacedSageWallClass != NULL && SageCubeClass != NULL)
+	{
+		//Set Spawn Collision Handling Override
+		FActorSpawnParameters PlacedWallSpawnParams;
+		PlacedWallSpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+		// one actor draws every segment of the wall
+		APlacedSageWall* placedWall = World->SpawnActor<APlacedSageWall>(PlacedSageWallClass, FinalLoc, FinalRot, PlacedWallSpawnParams);
+
+		if (placedWall != NULL)
+		{
+			placedWall->BuildSegments(SageCubeClass, segmentCount, segmentSpacing, segmentStartOffset);
+		}
+	}
+
+	else
+	{
+		// places the sage cubes in the correct spot based on the segment offset
+		// to create a small gap between each of them
+		for (int32 i = 0; i < segmentCount; i++)
+		{
+			SpawnSageCube(FinalLoc, FinalRot, FVector(segmentStartOffset + i * segmentSpacing, 0.0f, 0.0f));
+		}
+	}
+}
+
 // Called when the game starts or when spawned
 void ASageWall::BeginPlay()
 {
 	Super::BeginPlay();
 
+	// placing starts as soon as the wall is spawned
+	PushPlacementInput();
+}
+
+void ASageWall::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	// disables input for this class using the player controller
+	DisableInput(UGameplayStatics::GetPlayerController(GetWorld(), 0));
+
+	Super::EndPlay(EndPlayReason);
+}
+
+// enables input for this class once for the whole time the wall is being placed
+void ASageWall::PushPlacementInput()
+{
+	placingPlayer = Cast<ACourseworkCodeCharacter>(UGameplayStatics::GetPlayerPawn(GetWorld(), 0));
+
+	// tick after the player has moved this frame so the preview never reads last frame's camera
+	// the character already ticks after its controller, which applies the look input
+	if (placingPlayer.IsValid())
+	{
+		AddTickPrerequisiteActor(placingPlayer.Get());
+		AddTickPrerequisiteComponent(placingPlayer->GetCharacterMovement());
+	}
+
+	EnableInput(UGameplayStatics::GetPlayerController(GetWorld(), 0));
+
+	if (InputComponent != NULL)
+	{
+		// binds the mouse x-axis once to control the rotation of the wall
+		// the input isn't consumed, so the character still turns the camera while the wall isn't being rotated
+		FInputAxisBinding& turnBinding = InputComponent->BindAxis("SageWallTurn", this, &ASageWall::RotateWall);
+		turnBinding.bConsumeInput = false;
+	}
 }
 
 
@@ -107,7 +220,8 @@ void ASageWall::BeginPlay()
 // which is used for turning the wall on the spot
 void ASageWall::RotateWall(float val)
 {
-	if (val != 0.0f)
+	// the binding stays for the whole placement, only rotate while the player is holding rotate
+	if (val != 0.0f && placingPlayer.IsValid() && placingPlayer->getIsRotatingWall())
 	{
 		// multiply the input variable by delta time in order to slow down the rotation
 		// as the rotation was far too fast during gameplay
@@ -132,194 +246,463 @@ void ASageWall::Tick(float DeltaTime)
 		// casts to the player character in order to access the character variables and functions
 		class ACourseworkCodeCharacter* playerPawn = Cast<ACourseworkCodeCharacter>(UGameplayStatics::GetPlayerPawn(GetWorld(), 0));
 
+		if (playerPawn == NULL)
+		{
+			return;
+		}
+
 		// checks if player is currently placing the sage wall
 		// if it is, carry out the placing
 		if (playerPawn->getIsPlacingWall() == true)
 		{
+			FVector cameraLocation;
+			FRotator cameraRotation;
+			GetPlacementView(playerPawn, cameraLocation, cameraRotation);
+			const bool inputChanged = HasPlacementInputChanged(cameraLocation, cameraRotation);
 
-			// set start point and calculate end point for the line trace where the sage wall
-			// could possibly spawn at
-
-			FVector startPoint = playerPawn->GetFirstPersonCameraComponent()->GetComponentLocation();
-			FRotator camRotator = playerPawn->GetFirstPersonCameraComponent()->GetComponentRotation();
+			// nothing that moves the wall has changed, so the last placement still stands
+			if (!inputChanged && isPlacementSettled)
+			{
+				placementCacheHits++;
+				INC_DWORD_STAT(STAT_SageWallPlacementReused);
+				SET_FLOAT_STAT(STAT_SageWallPlacementReuseRate, 100.0f * placementCacheHits / (placementCacheHits + placementCacheMisses));
+				return;
+			}
 
-			// rotate the offset from camera to calculate the correct rotation
-			// of the maximum reach of the line trace
-			FVector rotatedVector = camRotator.RotateVector(spawnDistanceFromPlayer);
+			placementCacheMisses++;
+			INC_DWORD_STAT(STAT_SageWallPlacementEvaluated);
+			SET_FLOAT_STAT(STAT_SageWallPlacementReuseRate, 100.0f * placementCacheHits / (placementCacheHits + placementCacheMisses));
 
-			// calculates the end point from adding the rotated offset vector to the start point
-			// then create a transform 
-			FVector transformLoc = startPoint + rotatedVector;
-			FTransform lineTraceTransform(camRotator,transformLoc,FVector(1.0f,1.0f,1.0f));
+			lastCameraLocation = cameraLocation;
+			lastCameraRotation = cameraRotation;
+			lastTurnAxisVal = turnAxisVal;
+			isPlacementSettled = false;
 
+			// nothing to place the preview with until the first async trace comes back
 			FHitResult hit;
+			if (!TracePlacement(playerPawn, hit))
+			{
+				return;
+			}
 
-			//Set Spawn Collision Handling Override
-			// ignore itself for collisions
-			FCollisionQueryParams traceParams;
-			traceParams.AddIgnoredActor(this);
+			// if the line trace hits flat ground, move the preview there
+			if (IsValidPlacementHit(hit))
+			{
+				const bool previewSettled = UpdatePlacementPreview(playerPawn, hit.Location, DeltaTime);
+				isPlacementSettled = previewSettled && !inputChanged;
+			}
 
-			// begin the line trace
-			bool bHit = GetWorld()->LineTraceSingleByChannel(hit, startPoint, lineTraceTransform.GetLocation(), ECC_Visibility, traceParams);
+			// if the line trace doesn't hit anything
+			else
+			{
+				CancelPlacement(playerPawn);
+			}
 
-			// draw debug lines to help with making sure the line is drawing correctly
-			DrawDebugLine(GetWorld(), startPoint, lineTraceTransform.GetLocation(), FColor::Red, false, 3.0f);
+		}
 
-			// sets variable to the location which the line trace hits
-			FVector hitLocation = hit.Location;
 
-			// set variable to the normal value of an object on the Z-Axis
-			// to control the wall spawning purely on the ground
-			float normalCheck = hit.Normal.Z;
+		// if the wall has been placed 
+		else
+		{
+			FinishPlacement();
+		}
 
-			// if the line trace does hit and the z-value normal is straight up
-			if (bHit && normalCheck == 1.0f)
-			{
-				// set initial location of the wall before rotating and offsetting
-				wallStaticMesh->SetWorldLocation(hitLocation);
 
+	}
 
-				// checks if player is inputting a rotation for the wall on the spot
-				// if it is rotating
-				if (playerPawn->getIsRotatingWall() == true)
-				{
-					// enables input for this class using the player controller
-					EnableInput(UGameplayStatics::GetPlayerController(GetWorld(),0));
-					
-					// disables the turn input axis temporarily so player doesn't rotate the camera on the x-axis
-					// by binding the turn input with no function call
-					InputComponent->BindAxis("Turn");
+}
 
-					// binds a new input axis temporarily using the mouse x-axis for input
-					// to control the rotation of the wall using the mouse 
-					InputComponent->BindAxis("SageWallTurn", this, &ASageWall::RotateWall);
+// the camera component is only turned to the control rotation when the camera manager updates at the end of the frame
+// so the control rotation is read directly to get this frame's view
+void ASageWall::GetPlacementView(ACourseworkCodeCharacter* playerPawn, FVector& outLocation, FRotator& outRotation) const
+{
+	const UCameraComponent* camera = playerPawn->GetFirstPersonCameraComponent();
 
-					// inverts the rotation so that the rotation makes more sense when
-					// rotating left or right
+	outLocation = camera->GetComponentLocation();
+	outRotation = camera->bUsePawnControlRotation ? playerPawn->GetControlRotation() : camera->GetComponentRotation();
+}
 
-					changeInRotation = -1.0f * turnAxisVal;
+// sets start point and calculates end point for the line trace where the sage wall could possibly spawn at
+void ASageWall::GetPlacementTraceSegment(ACourseworkCodeCharacter* playerPawn, FVector& outStart, FVector& outEnd) const
+{
+	FRotator camRotator;
+	GetPlacementView(playerPawn, outStart, camRotator);
 
+	// rotate the offset from camera to calculate the correct rotation
+	// of the maximum reach of the line trace
+	// then add the rotated offset vector to the start point
+	outEnd = outStart + camRotator.RotateVector(spawnDistanceFromPlayer);
+}
 
-					float newWallRotation;
-					float camYawVal = playerPawn->GetFirstPersonCameraComponent()->GetComponentRotation().Yaw;
+// sync mode traces and uses the result straight away
+// async mode reads back the trace submitted last frame and submits this frame's trace
+// the newest result is moved along its surface to this frame's view instead of tracing again
+bool ASageWall::TracePlacement(ACourseworkCodeCharacter* playerPawn, FHitResult& outHit)
+{
+	SCOPE_CYCLE_COUNTER(STAT_SageWallPlacementTrace);
 
-					// calculates the final rotation to set based on the original rotation
-					// with the camera rotation and the input rotation
-					newWallRotation = defaultRotation + camYawVal + changeInRotation;
-					
-					// sets rotation of the wall
-					wallStaticMesh->SetWorldRotation(FRotator(0.0f, newWallRotation, 0.0f));
-					
-					// new set of variables that take in the current location
-					// and rotation of the sage wall before setting the final location 
-					// with the offset in order to place the
-					// wall in the correct spot facing the player 
-					// in the middle and not off to the side
+	UWorld* const World = GetWorld();
 
-					FVector nextWorldLoc;
-					FVector currentWorldLoc = wallStaticMesh->GetComponentLocation();
-					FRotator currentWorldRot = wallStaticMesh->GetComponentRotation();
-					FVector centreRotatedVector = currentWorldRot.RotateVector(FVector(-300.0f, 0.0f, 0.0f));
+	FVector startPoint;
+	FVector endPoint;
+	GetPlacementTraceSegment(playerPawn, startPoint, endPoint);
 
-					// calculates offset with rotation 
-					nextWorldLoc = currentWorldLoc + centreRotatedVector;
+	// ignore itself for collisions
+	FCollisionQueryParams traceParams(SCENE_QUERY_STAT(SageWallPlacement), false, this);
 
+	// draw debug lines to help with making sure the line is drawing correctly
+	DrawDebugLine(World, startPoint, endPoint, FColor::Red, false, 3.0f);
 
-					// sets the final position of the wall
-					wallStaticMesh->SetWorldLocation(nextWorldLoc);
+	if (placementTraceMode == ESageWallTraceMode::Async)
+	{
+		// read back last frame's trace before it is replaced
+		FTraceDatum traceData;
+		if (World->QueryTraceData(pendingPlacementTrace, traceData))
+		{
+			lastPlacementHit = traceData.OutHits.Num() > 0 ? traceData.OutHits[0] : FHitResult();
+			hasPlacementHit = true;
+		}
 
-					// saves the final location and rotation of the wall
-					// to these variables in order to help set the cubes correctly
+		pendingPlacementTrace = World->AsyncLineTraceByChannel(EAsyncTraceType::Single, startPoint, endPoint, ECC_Visibility, traceParams);
 
-					finalLocation = wallStaticMesh->GetComponentLocation();
-					finalRotation = wallStaticMesh->GetComponentRotation();
-					
+		if (!hasPlacementHit)
+		{
+			return false;
+		}
 
+		outHit = lastPlacementHit;
+		PredictPlacementHit(startPoint, endPoint, outHit);
+		return true;
+	}
 
-				}
+	World->LineTraceSingleByChannel(outHit, startPoint, endPoint, ECC_Visibility, traceParams);
+	return true;
+}
 
-				else
-				{
-					// disables input for this class using the player controller
-					DisableInput(UGameplayStatics::GetPlayerController(GetWorld(), 0));
+// the wall is only placed on flat ground, so the plane of the last hit is where this frame's trace would land
+// unless the view has moved onto a different surface, which the next result picks up a frame later
+void ASageWall::PredictPlacementHit(const FVector& startPoint, const FVector& endPoint, FHitResult& hit)
+{
+	if (!hit.bBlockingHit)
+	{
+		return;
+	}
 
+	const FVector traceDirection = endPoint - startPoint;
+	const float approach = FVector::DotProduct(traceDirection, hit.ImpactNormal);
 
-					float newWallRotation;
-					float camYawVal = playerPawn->GetFirstPersonCameraComponent()->GetComponentRotation().Yaw;
+	// the segment runs along or away from the surface
+	if (approach >= -KINDA_SMALL_NUMBER)
+	{
+		return;
+	}
 
-					// calculates the final rotation to set based on the original rotation
-					// with the camera rotation and the input rotation
-					newWallRotation = defaultRotation + camYawVal + changeInRotation;
+	const float time = FVector::DotProduct(hit.ImpactPoint - startPoint, hit.ImpactNormal) / approach;
+	if (time < 0.0f || time > 1.0f)
+	{
+		return;
+	}
 
-					// sets rotation of the wall
-					wallStaticMesh->SetWorldRotation(FRotator(0.0f, newWallRotation, 0.0f));
+	const FVector predictedPoint = startPoint + traceDirection * time;
+	hit.Location = predictedPoint;
+	hit.ImpactPoint = predictedPoint;
+	hit.TraceStart = startPoint;
+	hit.TraceEnd = endPoint;
+	hit.Time = time;
+	hit.Distance = traceDirection.Size() * time;
+}
 
-					// new set of variables that take in the current location
-					// and rotation of the sage wall before setting the final location 
-					// with the offset in order to place the
-					// wall in the correct spot facing the player 
-					// in the middle and not off to the side
+// checks the slope of the hit surface to control the wall spawning purely on the ground
+// anything within the walkable surface cache's slope tolerance is accepted
+bool ASageWall::IsValidPlacementHit(const FHitResult& hit) const
+{
+	if (!hit.bBlockingHit)
+	{
+		return false;
+	}
 
-					FVector nextWorldLoc;
-					FVector currentWorldLoc = wallStaticMesh->GetComponentLocation();
-					FRotator currentWorldRot = wallStaticMesh->GetComponentRotation();
-					FVector centreRotatedVector = currentWorldRot.RotateVector(FVector(-300.0f, 0.0f, 0.0f));
+	UWorld* const World = GetWorld();
+	const UWalkableSurfaceCache* surfaceCache = World != NULL ? World->GetSubsystem<UWalkableSurfaceCache>() : NULL;
 
-					// calculates offset with rotation 
-					nextWorldLoc = currentWorldLoc + centreRotatedVector;
+	return surfaceCache != NULL ? surfaceCache->IsWalkableNormal(hit.ImpactNormal) : hit.ImpactNormal.Z == 1.0f;
+}
 
-					// sets the final position of the wall
-					wallStaticMesh->SetWorldLocation(nextWorldLoc);
+// spreads the samples evenly along each segment, on the same line the segments are spawned along
+void ASageWall::GetFootprintPoints(const FVector& wallLocation, const FRotator& wallRotation, TArray<FVector>& outPoints) const
+{
+	outPoints.Reset();
 
-					// saves the final location and rotation of the wall
-					// to these variables in order to help set the cubes correctly
+	const int32 numSamples = FMath::Max(footprintSamplesPerSegment, 1);
 
-					finalLocation = wallStaticMesh->GetComponentLocation();
-					finalRotation = wallStaticMesh->GetComponentRotation();
-				}
-			}
+	for (int32 i = 0; i < segmentCount; i++)
+	{
+		for (int32 sample = 0; sample < numSamples; sample++)
+		{
+			const float offset = segmentStartOffset + (i + (sample + 0.5f) / numSamples) * segmentSpacing;
+			outPoints.Add(wallLocation + wallRotation.RotateVector(FVector(offset, 0.0f, 0.0f)));
+		}
+	}
+}
 
-			// if the line trace doesn't hit anything
-			else
-			{
-				// destroy the wall
-				// reset player from placing
-				// set wall is placed
+// looks up every footprint point in the walkable surface cache
+// points the cache hasn't seen yet are traced by the cache
+bool ASageWall::IsValidFootprint(const FVector& wallLocation, const FRotator& wallRotation)
+{
+	UWorld* const World = GetWorld();
+	UWalkableSurfaceCache* surfaceCache = World != NULL ? World->GetSubsystem<UWalkableSurfaceCache>() : NULL;
 
-				Destroy();
-				playerPawn->setIsPlacingWall(false);
-				isWallPlaced = true;
-			}
+	if (surfaceCache == NULL)
+	{
+		return true;
+	}
 
-		}
+	GetFootprintPoints(wallLocation, wallRotation, footprintPoints);
 
+	return surfaceCache->IsFootprintWalkable(footprintPoints, wallLocation.Z);
+}
 
-		// if the wall has been placed 
-		else
+// compares against the input the placement was last worked out with, not last frame's
+// so slow movement still adds up to a change eventually
+bool ASageWall::HasPlacementInputChanged(const FVector& cameraLocation, const FRotator& cameraRotation) const
+{
+	return !cameraLocation.Equals(lastCameraLocation, placementLocationEpsilon)
+		|| FMath::Abs(FRotator::NormalizeAxis(cameraRotation.Yaw - lastCameraRotation.Yaw)) > placementRotationEpsilon
+		|| FMath::Abs(FRotator::NormalizeAxis(cameraRotation.Pitch - lastCameraRotation.Pitch)) > placementRotationEpsilon
+		|| FMath::Abs(turnAxisVal - lastTurnAxisVal) > placementTurnEpsilon;
+}
+
+// places the wall preview at the hit location, facing the player
+bool ASageWall::UpdatePlacementPreview(ACourseworkCodeCharacter* playerPawn, const FVector& hitLocation, float DeltaTime)
+{
+	// smooth out the preview so it doesn't step between trace results
+	FVector nextPreviewLocation = hitLocation;
+	if (hasPreviewLocation && previewInterpSpeed > 0.0f)
+	{
+		nextPreviewLocation = FMath::VInterpTo(previewLocation, hitLocation, DeltaTime, previewInterpSpeed);
+	}
+
+	// inverts the rotation so that the rotation makes more sense when
+	// rotating left or right
+	// the turn value only changes while the player is rotating the wall
+	changeInRotation = -1.0f * turnAxisVal;
+
+	// the placement input is bound once, so this should never grow while rotate is held
+	if (InputComponent != NULL)
+	{
+		INC_DWORD_STAT_BY(STAT_SageWallAxisBindings, InputComponent->AxisBindings.Num());
+	}
+
+	FVector camLocation;
+	FRotator camRotation;
+	GetPlacementView(playerPawn, camLocation, camRotation);
+
+	float newWallRotation;
+	float camYawVal = camRotation.Yaw;
+
+	// calculates the final rotation to set based on the original rotation
+	// with the camera rotation and the input rotation
+	newWallRotation = defaultRotation + camYawVal + changeInRotation;
+	FRotator nextWorldRot = FRotator(0.0f, newWallRotation, 0.0f);
+
+	// offsets the location with the rotation in order to place the
+	// wall in the correct spot facing the player 
+	// in the middle and not off to the side
+	FVector centreRotatedVector = nextWorldRot.RotateVector(FVector(-300.0f, 0.0f, 0.0f));
+	FVector nextWorldLoc = nextPreviewLocation + centreRotatedVector;
+
+	// keep the preview at its last valid spot if part of the wall would be off the ground
+	if (!IsValidFootprint(nextWorldLoc, nextWorldRot))
+	{
+		return true;
+	}
+
+	previewLocation = nextPreviewLocation;
+	hasPreviewLocation = true;
+
+	// sets the final position and rotation of the wall
+	wallStaticMesh->SetWorldLocationAndRotation(nextWorldLoc, nextWorldRot);
+
+	// saves the final location and rotation of the wall
+	// to these variables in order to help set the cubes correctly
+
+	finalLocation = wallStaticMesh->GetComponentLocation();
+	finalRotation = wallStaticMesh->GetComponentRotation();
+
+	// the preview keeps moving until the smoothing catches up with the hit
+	return previewLocation.Equals(hitLocation, placementLocationEpsilon);
+}
+
+// destroy the wall
+// reset player from placing
+// set wall is placed
+void ASageWall::CancelPlacement(ACourseworkCodeCharacter* playerPawn)
+{
+	Destroy();
+	playerPawn->setIsPlacingWall(false);
+	isWallPlaced = true;
+}
+
+// sets wall as placed
+// destroys the wall, which also pops the placement input
+void ASageWall::FinishPlacement()
+{
+	isWallPlaced = true;
+
+	Destroy();
+
+	// spawns the segments of the wall at the last placing location
+	// nothing is spawned if the preview never found anywhere the wall fits
+	if (hasPreviewLocation)
+	{
+		SpawnWallSegments(finalLocation, finalRotation);
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Tests
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSageWallPlacementLagTest, "CourseworkCode.SageWall.PlacementHasNoFrameLag", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSageWallAxisBindingHoldTest, "CourseworkCode.SageWall.AxisBindingsConstantWhileRotating", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+namespace SageWallTests
+{
+	// spawns flat, blocking ground with its top at the given height
+	static void SpawnGround(const FCourseworkCodeTestWorld& testWorld, float groundZ)
+	{
+		AActor* ground = testWorld.SpawnActor<AActor>(FTransform::Identity);
+
+		UBoxComponent* groundBox = NewObject<UBoxComponent>(ground);
+		groundBox->SetBoxExtent(FVector(100000.0f, 100000.0f, 10.0f));
+		groundBox->SetCollisionProfileName(UCollisionProfile::BlockAll_ProfileName);
+		ground->SetRootComponent(groundBox);
+		groundBox->RegisterComponent();
+		groundBox->SetWorldLocation(FVector(0.0f, 0.0f, groundZ - 10.0f));
+	}
+}
+
+// walks and turns the player at a fixed timestep over flat ground, ticking the whole world each step
+// the wall mesh has to be where this step's camera puts it, so the wall has to tick after the player moves
+// async results are always a step old, so they only pass if they are carried along to this step's view
+bool FSageWallPlacementLagTest::RunTest(const FString& Parameters)
+{
+	FCourseworkCodeTestWorld testWorld(true);
+	SageWallTests::SpawnGround(testWorld, 0.0f);
+
+	APlayerController* playerController = testWorld.SpawnActor<APlayerController>(FTransform::Identity);
+	ACourseworkCodeCharacter* player = testWorld.SpawnActor<ACourseworkCodeCharacter>(FTransform(FVector(0.0f, 0.0f, 100.0f)));
+	playerController->Possess(player);
+	player->setIsPlacingWall(true);
+
+	const float fixedDeltaTime = 1.0f / 60.0f;
+	const float turnPerStep = 2.0f;
+
+	for (ESageWallTraceMode traceMode : { ESageWallTraceMode::Sync, ESageWallTraceMode::Async })
+	{
+		const TCHAR* modeName = traceMode == ESageWallTraceMode::Sync ? TEXT("Sync") : TEXT("Async");
+
+		// the wall is spawned into a world that has begun play, so it pushes its input and tick prerequisites straight away
+		ASageWall* sageWall = testWorld.SpawnActor<ASageWall>(FTransform::Identity);
+		sageWall->placementTraceMode = traceMode;
+
+		// steep enough that the trace reaches the ground in front of the player
+		sageWall->spawnDistanceFromPlayer = FVector(1000.0f, 0.0f, -400.0f);
+
+		bool ticksAfterPlayer = false;
+		for (const FTickPrerequisite& prerequisite : sageWall->PrimaryActorTick.GetPrerequisites())
 		{
+			ticksAfterPlayer |= prerequisite.Get() == &player->PrimaryActorTick;
+		}
+		TestTrue(FString::Printf(TEXT("%s wall ticks after the player"), modeName), ticksAfterPlayer);
 
-			// sets wall as placed
-			// disables input incase the player was still attempting to rotate
-			// destroys the wall
+		const FVector startCameraLocation = player->GetFirstPersonCameraComponent()->GetComponentLocation();
 
-			isWallPlaced = true;
-			DisableInput(UGameplayStatics::GetPlayerController(GetWorld(), 0));
+		for (int32 step = 0; step < 20 && !sageWall->IsPendingKill(); step++)
+		{
+			// move and turn the camera, both are only applied while the world ticks
+			FRotator controlRotation = playerController->GetControlRotation();
+			controlRotation.Yaw += turnPerStep;
+			playerController->SetControlRotation(controlRotation);
+			player->AddMovementInput(FRotator(0.0f, controlRotation.Yaw, 0.0f).Vector(), 1.0f);
 
-			Destroy();
+			testWorld.Tick(fixedDeltaTime);
 
-			// spawns three sage cubes
-			// places the sage cubes in the correct spot based on an entered vector
-			// to create a small gap between each of them
+			// the first async step has nothing to read back yet
+			if (traceMode == ESageWallTraceMode::Async && step == 0)
+			{
+				continue;
+			}
 
-			SpawnSageCube(finalLocation,finalRotation,FVector(200.0f,0.0f,0.0f));
-			SpawnSageCube(finalLocation, finalRotation, FVector(401.0f, 0.0f, 0.0f));
-			SpawnSageCube(finalLocation, finalRotation, FVector(-1.0f, 0.0f, 0.0f));
+			// where this step's camera looks down onto the ground at z = 0
+			const FVector cameraLocation = player->GetFirstPersonCameraComponent()->GetComponentLocation();
+			const FVector traceDirection = controlRotation.RotateVector(sageWall->spawnDistanceFromPlayer);
+			const FVector groundHit = cameraLocation + traceDirection * (cameraLocation.Z / -traceDirection.Z);
 
+			const FRotator expectedRotation(0.0f, sageWall->defaultRotation + controlRotation.Yaw, 0.0f);
+			const FVector expectedLocation = groundHit + expectedRotation.RotateVector(FVector(-300.0f, 0.0f, 0.0f));
 
+			TestEqual(*FString::Printf(TEXT("%s wall mesh location at step %d"), modeName, step),
+				sageWall->wallStaticMesh->GetComponentLocation(), expectedLocation, 1.0f);
+			TestTrue(FString::Printf(TEXT("%s wall mesh rotation at step %d"), modeName, step),
+				sageWall->wallStaticMesh->GetComponentRotation().Equals(expectedRotation, 0.1f));
 		}
 
+		TestFalse(FString::Printf(TEXT("%s placement is still going"), modeName), sageWall->IsPendingKill());
+		TestTrue(FString::Printf(TEXT("%s player walked during the placement"), modeName),
+			FVector::Dist2D(player->GetFirstPersonCameraComponent()->GetComponentLocation(), startCameraLocation) > 1.0f);
 
+		sageWall->Destroy();
 	}
 
+	return true;
+}
+
+// holds rotate for a long placement and checks the wall never adds another binding
+bool FSageWallAxisBindingHoldTest::RunTest(const FString& Parameters)
+{
+	FCourseworkCodeTestWorld testWorld;
+
+	APlayerController* playerController = testWorld.SpawnActor<APlayerController>(FTransform::Identity);
+	ACourseworkCodeCharacter* player = testWorld.SpawnActor<ACourseworkCodeCharacter>(FTransform(FVector(0.0f, 0.0f, 200.0f)));
+	playerController->Possess(player);
+
+	// the wall is ticked directly without the world, so no async trace would ever come back
+	ASageWall* sageWall = testWorld.SpawnActor<ASageWall>(FTransform::Identity);
+	sageWall->placementTraceMode = ESageWallTraceMode::Sync;
+	sageWall->PushPlacementInput();
+
+	if (!TestNotNull(TEXT("Placement input component"), sageWall->InputComponent))
+	{
+		return false;
+	}
+
+	// ground in reach of the placement trace, so the placement isn't cancelled
+	FVector cameraLocation;
+	FRotator cameraRotation;
+	sageWall->GetPlacementView(player, cameraLocation, cameraRotation);
+	SageWallTests::SpawnGround(testWorld, cameraLocation.Z + sageWall->spawnDistanceFromPlayer.Z * 0.5f);
+
+	const int32 startBindings = sageWall->InputComponent->AxisBindings.Num();
+	int32 maxBindings = startBindings;
+
+	player->setIsPlacingWall(true);
+	player->setisRotatingWall(true);
+
+	// ten seconds of rotation at 60 fps, the input calls the binding before the wall ticks
+	const float fixedDeltaTime = 1.0f / 60.0f;
+	for (int32 frame = 0; frame < 600 && !sageWall->IsPendingKill(); frame++)
+	{
+		sageWall->RotateWall(1.0f);
+		sageWall->Tick(fixedDeltaTime);
+
+		maxBindings = FMath::Max(maxBindings, sageWall->InputComponent->AxisBindings.Num());
+	}
+
+	TestFalse(TEXT("Placement is still going after the hold"), sageWall->IsPendingKill());
+	TestEqual(TEXT("Axis bindings after holding rotate"), maxBindings, startBindings);
+
+	return true;
 }
 
+#endif
@@ -6,8 +6,23 @@
 #include "Components/SceneComponent.h"
 #include "Components/StaticMeshComponent.h"
 #include "GameFramework/Actor.h"
+#include "WorldCollision.h"
 #include "SageWall.generated.h"
 
+class ACourseworkCodeCharacter;
+
+/** how the placement trace for the wall preview is run */
+UENUM()
+enum class ESageWallTraceMode : uint8
+{
+	// traced on the game thread and used in the same frame
+	Sync,
+
+	// submitted to the async trace queue and read back the next frame, the game thread never traces
+	// the surface last frame's trace hit is carried along to this frame's view so the preview doesn't lag a frame behind
+	Async
+};
+
 UCLASS(config=game)
 class COURSEWORKCODE_API ASageWall : public AActor
 {
@@ -22,9 +37,20 @@ public:
 	UPROPERTY(EditAnywhere)
 		TSubclassOf<class ASageCube> SageCubeClass;
 
+	/** placed wall class to spawn when instanced segments are used */
+	UPROPERTY(EditAnywhere)
+		TSubclassOf<class APlacedSageWall> PlacedSageWallClass;
+
 	// spawns a sage cube based on entered values for location and rotation
 	void SpawnSageCube(const FVector FinalLoc, const FRotator FinalRot, FVector RotateVal);
 
+	// true if placed walls are drawn as instanced segments instead of sage cube actors
+	bool getUseInstancedSegments() const { return useInstancedSegments; }
+
+	// spawns the wall segments at the final location and rotation
+	// either as one placed wall actor drawing every segment, or as one sage cube per segment
+	void SpawnWallSegments(const FVector FinalLoc, const FRotator FinalRot);
+
 protected:
 
 	/** sets the static mesh component for the sage wall */
@@ -64,16 +90,136 @@ protected:
 	UPROPERTY(EditAnywhere, BlueprintReadOnly)
 		FRotator finalRotation;
 
+	/** whether the placement trace blocks the game thread or can be read back the frame after it was submitted */
+	UPROPERTY(config, EditAnywhere, BlueprintReadOnly)
+		ESageWallTraceMode placementTraceMode;
+
+	/** how quickly the preview follows the placement trace, 0 moves it straight to the hit location
+	anything above 0 lags the preview behind the view, so it is 0 unless smoothing is wanted over zero lag */
+	UPROPERTY(config, EditAnywhere, BlueprintReadOnly)
+		float previewInterpSpeed;
+
+	// player placing the wall, rotation input is only used while they hold rotate
+	TWeakObjectPtr<ACourseworkCodeCharacter> placingPlayer;
+
+	// async placement trace submitted last frame
+	FTraceHandle pendingPlacementTrace;
+
+	// newest async placement result, carried along to the current view until the next one arrives
+	FHitResult lastPlacementHit;
+
+	// false until the first async placement trace has been read back
+	bool hasPlacementHit;
+
+	// smoothed location the preview is placed at
+	FVector previewLocation;
+
+	// false until the preview has been placed somewhere valid for the first time
+	bool hasPreviewLocation;
+
+	/** if true the placed wall is one actor with an instance per segment, otherwise a sage cube is spawned per segment */
+	UPROPERTY(config, EditAnywhere, BlueprintReadOnly)
+		bool useInstancedSegments;
+
+	/** number of segments the placed wall is made of */
+	UPROPERTY(config, EditAnywhere, BlueprintReadOnly)
+		int32 segmentCount;
+
+	/** distance between the start of each segment along the wall */
+	UPROPERTY(config, EditAnywhere, BlueprintReadOnly)
+		float segmentSpacing;
+
+	/** offset of the first segment along the wall from the final location */
+	UPROPERTY(config, EditAnywhere, BlueprintReadOnly)
+		float segmentStartOffset;
+
+	/** number of points checked for walkable ground under each segment */
+	UPROPERTY(config, EditAnywhere, BlueprintReadOnly)
+		int32 footprintSamplesPerSegment;
+
+	// points under the wall checked against the walkable surface cache, kept between frames to avoid reallocating
+	TArray<FVector> footprintPoints;
+
+	/** camera movement needed before the placement is worked out again */
+	UPROPERTY(config, EditAnywhere, BlueprintReadOnly)
+		float placementLocationEpsilon;
+
+	/** camera yaw or pitch change in degrees needed before the placement is worked out again */
+	UPROPERTY(config, EditAnywhere, BlueprintReadOnly)
+		float placementRotationEpsilon;
+
+	/** rotation input change needed before the placement is worked out again */
+	UPROPERTY(config, EditAnywhere, BlueprintReadOnly)
+		float placementTurnEpsilon;
+
+	// camera and rotation input the placement was last worked out with
+	FVector lastCameraLocation;
+	FRotator lastCameraRotation;
+	float lastTurnAxisVal;
+
+	// true once the last placement result matches the current input and the preview has stopped moving
+	bool isPlacementSettled;
+
+	// frames the last placement was reused for, and frames it had to be worked out again
+	int32 placementCacheHits;
+	int32 placementCacheMisses;
+
 protected:
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
 
+	// pops the placement input off the player's input stack
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	// pushes the placement input onto the player's input stack with a single rotation binding
+	// and makes the wall tick after the player so it sees the player's view for this frame
+	void PushPlacementInput();
+
 	// function that takes in the input of the mouse X-axis movement
 	// and saves the input to another float variable
 	void RotateWall(float val);
 
+	// gets the player's view for this frame, the same one the camera will show
+	void GetPlacementView(ACourseworkCodeCharacter* playerPawn, FVector& outLocation, FRotator& outRotation) const;
+
+	// works out the start and end of the placement trace from the player's camera
+	void GetPlacementTraceSegment(ACourseworkCodeCharacter* playerPawn, FVector& outStart, FVector& outEnd) const;
+
+	// runs the placement trace from this frame's view using the current trace mode
+	// returns false if there is no result yet, which only happens on the first async frame
+	bool TracePlacement(ACourseworkCodeCharacter* playerPawn, FHitResult& outHit);
+
+	// moves the hit to where this frame's trace segment crosses the surface the hit was on
+	// the hit is left alone if the segment doesn't reach the surface
+	static void PredictPlacementHit(const FVector& startPoint, const FVector& endPoint, FHitResult& hit);
+
+	// true if the wall can be placed at the hit
+	bool IsValidPlacementHit(const FHitResult& hit) const;
+
+	// works out the points along the wall that need ground under them
+	void GetFootprintPoints(const FVector& wallLocation, const FRotator& wallRotation, TArray<FVector>& outPoints) const;
+
+	// true if there is walkable ground under the whole wall at the location and rotation
+	bool IsValidFootprint(const FVector& wallLocation, const FRotator& wallRotation);
+
+	// true if the camera or rotation input has moved further than the epsilons since the placement was last worked out
+	bool HasPlacementInputChanged(const FVector& cameraLocation, const FRotator& cameraRotation) const;
+
+	// moves and rotates the preview to the hit location
+	// the preview stays where it was if the wall wouldn't fit there
+	// returns true once the preview has nowhere else to move to for this hit
+	bool UpdatePlacementPreview(ACourseworkCodeCharacter* playerPawn, const FVector& hitLocation, float DeltaTime);
+
+	// removes the preview without placing a wall
+	void CancelPlacement(ACourseworkCodeCharacter* playerPawn);
+
+	// removes the preview and spawns the wall where it was
+	void FinishPlacement();
+
 public:	
 	// Called every frame
 	virtual void Tick(float DeltaTime) override;
 
+	friend class FSageWallPlacementLagTest;
+	friend class FSageWallAxisBindingHoldTest;
 };
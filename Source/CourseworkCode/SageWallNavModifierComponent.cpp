@@ -0,0 +1,105 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "SageWallNavModifierComponent.h"
+#include "CourseworkCode.h"
+#include "AI/NavigationSystemHelpers.h"
+#include "AI/NavigationModifier.h"
+#include "NavigationSystem.h"
+#include "NavAreas/NavArea_Null.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Sage Wall Nav Updates"), STAT_SageWallNavUpdates, STATGROUP_CourseworkCode);
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("Sage Wall Nav Rebuild ms"), STAT_SageWallNavRebuildMs, STATGROUP_CourseworkCode);
+
+DEFINE_LOG_CATEGORY_STATIC(LogSageWallNav, Log, All);
+
+USageWallNavModifierComponent::USageWallNavModifierComponent()
+{
+	areaClass = UNavArea_Null::StaticClass();
+	footprintPadding = 10.0f;
+	rebuildRequestTime = 0.0;
+	obstacleBox = FBox(ForceInit);
+
+	// the segment transforms are already in world space, so they don't need merging into the owner's root
+	bAttachToOwnersRoot = false;
+}
+
+// the dirty area is the old bounds plus the new bounds, so only the tiles under the wall are rebuilt
+void USageWallNavModifierComponent::SetObstacles(const FBox& localBox, const TArray<FTransform>& segmentToWorld)
+{
+	obstacleBox = localBox;
+	obstacleTransforms = segmentToWorld;
+
+	if (IsRegistered())
+	{
+		rebuildRequestTime = FPlatformTime::Seconds();
+		RefreshNavigationModifiers();
+
+		INC_DWORD_STAT(STAT_SageWallNavUpdates);
+	}
+}
+
+// a rotated transform turns the box into a convex footprint, so the area follows the wall instead of its world bounds
+// the padding is in world units, so it is scaled down into each segment's local space
+void USageWallNavModifierComponent::GetNavigationData(FNavigationRelevantData& Data) const
+{
+	for (const FTransform& segmentTransform : obstacleTransforms)
+	{
+		const FVector scale = segmentTransform.GetScale3D().GetAbs().ComponentMax(FVector(KINDA_SMALL_NUMBER));
+		const FBox paddedBox = obstacleBox.ExpandBy(FVector(footprintPadding, footprintPadding, 0.0f) / scale);
+
+		Data.Modifiers.Add(FAreaNavModifier(paddedBox, segmentTransform, areaClass));
+	}
+}
+
+bool USageWallNavModifierComponent::IsNavigationRelevant() const
+{
+	return obstacleBox.IsValid && obstacleTransforms.Num() > 0;
+}
+
+void USageWallNavModifierComponent::CalcAndCacheBounds() const
+{
+	Bounds = FBox(ForceInit);
+	for (const FTransform& segmentTransform : obstacleTransforms)
+	{
+		Bounds += obstacleBox.TransformBy(segmentTransform).ExpandBy(FVector(footprintPadding, footprintPadding, 0.0f));
+	}
+}
+
+void USageWallNavModifierComponent::OnRegister()
+{
+	Super::OnRegister();
+
+	UNavigationSystemV1* navSystem = FNavigationSystem::GetCurrent<UNavigationSystemV1>(GetWorld());
+	if (navSystem != NULL)
+	{
+		navSystem->OnNavigationGenerationFinishedDelegate.AddDynamic(this, &USageWallNavModifierComponent::OnNavigationGenerationFinished);
+	}
+}
+
+void USageWallNavModifierComponent::OnUnregister()
+{
+	UNavigationSystemV1* navSystem = FNavigationSystem::GetCurrent<UNavigationSystemV1>(GetWorld());
+	if (navSystem != NULL)
+	{
+		navSystem->OnNavigationGenerationFinishedDelegate.RemoveDynamic(this, &USageWallNavModifierComponent::OnNavigationGenerationFinished);
+	}
+
+	Super::OnUnregister();
+}
+
+// the tiles are built on worker threads, this is called once every dirty tile is done
+// other changes to the navmesh in the same window are included in the time
+void USageWallNavModifierComponent::OnNavigationGenerationFinished(ANavigationData* NavData)
+{
+	if (rebuildRequestTime <= 0.0)
+	{
+		return;
+	}
+
+	const float rebuildMs = (FPlatformTime::Seconds() - rebuildRequestTime) * 1000.0;
+	rebuildRequestTime = 0.0;
+
+	SET_FLOAT_STAT(STAT_SageWallNavRebuildMs, rebuildMs);
+	UE_LOG(LogSageWallNav, Verbose, TEXT("%s navmesh rebuilt around %d segments in %.2f ms"), *GetNameSafe(GetOwner()), obstacleTransforms.Num(), rebuildMs);
+}
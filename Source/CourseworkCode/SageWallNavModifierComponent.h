@@ -0,0 +1,60 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "AI/Navigation/NavRelevantComponent.h"
+#include "SageWallNavModifierComponent.generated.h"
+
+class ANavigationData;
+class UNavArea;
+
+/**
+ * Marks the footprint of each standing wall segment as an area on the navmesh
+ * only the tiles under the changed boxes are rebuilt when a wall is placed or loses a segment
+ * which is cheap with the navmesh set to rebuild dynamic modifiers only
+ */
+UCLASS(ClassGroup = (Navigation), meta = (BlueprintSpawnableComponent))
+class COURSEWORKCODE_API USageWallNavModifierComponent : public UNavRelevantComponent
+{
+	GENERATED_BODY()
+
+public:
+
+	USageWallNavModifierComponent();
+
+	// replaces the segments covered by the wall and asks for the navmesh under them to be rebuilt
+	// every segment is the same local box placed by its own transform, so rotated walls only cover their footprint
+	void SetObstacles(const FBox& localBox, const TArray<FTransform>& segmentToWorld);
+
+	// INavRelevantInterface
+	virtual void GetNavigationData(FNavigationRelevantData& Data) const override;
+	virtual bool IsNavigationRelevant() const override;
+	// End of INavRelevantInterface
+
+protected:
+
+	/** area applied under the wall, null area cuts the wall out of the navmesh so bots path around it */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly)
+	TSubclassOf<UNavArea> areaClass;
+
+	/** how far the boxes are grown on each side so agents don't brush against the wall */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly)
+	float footprintPadding;
+
+	// local box of a segment, and the world transform of each standing segment
+	FBox obstacleBox;
+	TArray<FTransform> obstacleTransforms;
+
+	// time the last rebuild was asked for, cleared once the navmesh has caught up
+	double rebuildRequestTime;
+
+	virtual void CalcAndCacheBounds() const override;
+
+	virtual void OnRegister() override;
+	virtual void OnUnregister() override;
+
+	// records how long the rebuild took once the navmesh has finished building
+	UFUNCTION()
+	void OnNavigationGenerationFinished(ANavigationData* NavData);
+};
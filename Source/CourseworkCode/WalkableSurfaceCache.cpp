@@ -0,0 +1,236 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "WalkableSurfaceCache.h"
+#include "CourseworkCode.h"
+#include "Engine/World.h"
+#include "GameFramework/Pawn.h"
+#include "Kismet/GameplayStatics.h"
+#include "HAL/IConsoleManager.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Walkable Surface Hits"), STAT_WalkableSurfaceHits, STATGROUP_CourseworkCode);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Walkable Surface Misses"), STAT_WalkableSurfaceMisses, STATGROUP_CourseworkCode);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Walkable Surface Regions"), STAT_WalkableSurfaceRegions, STATGROUP_CourseworkCode);
+DECLARE_CYCLE_STAT(TEXT("Walkable Surface Trace"), STAT_WalkableSurfaceTrace, STATGROUP_CourseworkCode);
+
+DEFINE_LOG_CATEGORY_STATIC(LogWalkableSurface, Log, All);
+
+// sets default grid settings, these can be overridden in DefaultGame.ini
+UWalkableSurfaceCache::UWalkableSurfaceCache()
+{
+	cellSize = 50.0f;
+	regionCells = 16;
+	maxWalkableSlope = 10.0f;
+	maxStepHeight = 30.0f;
+	traceHalfHeight = 200.0f;
+
+	minWalkableNormalZ = 1.0f;
+}
+
+// config values are loaded by now, so the slope limit can be turned into a normal limit
+void UWalkableSurfaceCache::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	cellSize = FMath::Max(cellSize, 1.0f);
+	regionCells = FMath::Max(regionCells, 1);
+	minWalkableNormalZ = FMath::Cos(FMath::DegreesToRadians(FMath::Clamp(maxWalkableSlope, 0.0f, 89.0f)));
+}
+
+void UWalkableSurfaceCache::Deinitialize()
+{
+	Reset();
+
+	Super::Deinitialize();
+}
+
+bool UWalkableSurfaceCache::GetSurface(const FVector& location, FWalkableSurfaceCell& outCell)
+{
+	FWalkableSurfaceCell& cell = FindOrAddCell(location);
+
+	// a cell is traced again if it was traced from another floor and the ground it found isn't under this location either
+	const bool isCached = cell.isSampled
+		&& (FMath::Abs(cell.height - location.Z) <= maxStepHeight || FMath::Abs(cell.sampleHeight - location.Z) <= maxStepHeight);
+
+	if (isCached)
+	{
+		INC_DWORD_STAT(STAT_WalkableSurfaceHits);
+	}
+
+	else
+	{
+		INC_DWORD_STAT(STAT_WalkableSurfaceMisses);
+		SampleCell(cell, GetCellCoord(location), location.Z);
+	}
+
+	outCell = cell;
+
+	return cell.hasSurface;
+}
+
+// anything within the slope tolerance counts, not just perfectly flat ground
+bool UWalkableSurfaceCache::IsWalkableNormal(const FVector& normal) const
+{
+	return normal.Z >= minWalkableNormalZ;
+}
+
+bool UWalkableSurfaceCache::IsFootprintWalkable(const TArray<FVector>& footprintPoints, float baseHeight)
+{
+	for (const FVector& point : footprintPoints)
+	{
+		FWalkableSurfaceCell cell;
+		if (!GetSurface(FVector(point.X, point.Y, baseHeight), cell))
+		{
+			return false;
+		}
+
+		if (cell.normalZ < minWalkableNormalZ || FMath::Abs(cell.height - baseHeight) > maxStepHeight)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+int32 UWalkableSurfaceCache::BakeArea(const FVector& centre, float radius)
+{
+	const FIntPoint minCoord = GetCellCoord(centre - FVector(radius, radius, 0.0f));
+	const FIntPoint maxCoord = GetCellCoord(centre + FVector(radius, radius, 0.0f));
+	const float radiusSquared = FMath::Square(radius);
+
+	int32 numTraced = 0;
+	for (int32 y = minCoord.Y; y <= maxCoord.Y; y++)
+	{
+		for (int32 x = minCoord.X; x <= maxCoord.X; x++)
+		{
+			const FVector cellCentre((x + 0.5f) * cellSize, (y + 0.5f) * cellSize, centre.Z);
+			if (FVector::DistSquared2D(cellCentre, centre) > radiusSquared)
+			{
+				continue;
+			}
+
+			FWalkableSurfaceCell& cell = FindOrAddCell(cellCentre);
+			if (!cell.isSampled)
+			{
+				SampleCell(cell, FIntPoint(x, y), centre.Z);
+				numTraced++;
+			}
+		}
+	}
+
+	return numTraced;
+}
+
+void UWalkableSurfaceCache::InvalidateArea(const FBox& area)
+{
+	const FIntPoint minCoord = GetCellCoord(area.Min);
+	const FIntPoint maxCoord = GetCellCoord(area.Max);
+
+	for (int32 y = minCoord.Y; y <= maxCoord.Y; y++)
+	{
+		for (int32 x = minCoord.X; x <= maxCoord.X; x++)
+		{
+			const FIntPoint regionCoord(FMath::FloorToInt((float)x / regionCells), FMath::FloorToInt((float)y / regionCells));
+
+			FWalkableSurfaceRegion* region = regions.Find(regionCoord);
+			if (region != NULL)
+			{
+				const int32 cellIndex = (y - regionCoord.Y * regionCells) * regionCells + (x - regionCoord.X * regionCells);
+				region->cells[cellIndex] = FWalkableSurfaceCell();
+			}
+		}
+	}
+}
+
+void UWalkableSurfaceCache::Reset()
+{
+	DEC_DWORD_STAT_BY(STAT_WalkableSurfaceRegions, regions.Num());
+
+	regions.Empty();
+}
+
+// one map lookup for the region, then an index into its cells
+FWalkableSurfaceCell& UWalkableSurfaceCache::FindOrAddCell(const FVector& location)
+{
+	const FIntPoint cellCoord = GetCellCoord(location);
+	const FIntPoint regionCoord(FMath::FloorToInt((float)cellCoord.X / regionCells), FMath::FloorToInt((float)cellCoord.Y / regionCells));
+
+	FWalkableSurfaceRegion* region = regions.Find(regionCoord);
+	if (region == NULL)
+	{
+		region = &regions.Add(regionCoord);
+		region->cells.SetNum(regionCells * regionCells);
+
+		INC_DWORD_STAT(STAT_WalkableSurfaceRegions);
+	}
+
+	const int32 cellIndex = (cellCoord.Y - regionCoord.Y * regionCells) * regionCells + (cellCoord.X - regionCoord.X * regionCells);
+
+	return region->cells[cellIndex];
+}
+
+// only static geometry and placed walls are traced, placed walls and cubes invalidate the cells under them when they change
+void UWalkableSurfaceCache::SampleCell(FWalkableSurfaceCell& cell, const FIntPoint& cellCoord, float traceHeight)
+{
+	SCOPE_CYCLE_COUNTER(STAT_WalkableSurfaceTrace);
+
+	const FVector cellCentre((cellCoord.X + 0.5f) * cellSize, (cellCoord.Y + 0.5f) * cellSize, traceHeight);
+	const FVector traceStart = cellCentre + FVector(0.0f, 0.0f, traceHalfHeight);
+	const FVector traceEnd = cellCentre - FVector(0.0f, 0.0f, traceHalfHeight);
+
+	FHitResult hit;
+	FCollisionQueryParams traceParams(SCENE_QUERY_STAT(WalkableSurface), false);
+
+	// the custom "SageWall" object channel used by the sage cube collision profile
+	FCollisionObjectQueryParams objectParams(ECC_WorldStatic);
+	objectParams.AddObjectTypesToQuery(ECC_GameTraceChannel2);
+
+	UWorld* const World = GetWorld();
+	const bool foundSurface = World != NULL && World->LineTraceSingleByObjectType(hit, traceStart, traceEnd, objectParams, traceParams);
+
+	// a cell with no ground keeps the height it was traced from, so a lookup from another floor traces it again
+	cell.isSampled = true;
+	cell.sampleHeight = traceHeight;
+	cell.hasSurface = foundSurface;
+	cell.height = foundSurface ? hit.ImpactPoint.Z : traceHeight;
+	cell.normalZ = foundSurface ? hit.ImpactNormal.Z : 0.0f;
+}
+
+FIntPoint UWalkableSurfaceCache::GetCellCoord(const FVector& location) const
+{
+	return FIntPoint(FMath::FloorToInt(location.X / cellSize), FMath::FloorToInt(location.Y / cellSize));
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Bake
+
+namespace WalkableSurfaceBake
+{
+	// traces every cell around the player so the first placements in the area don't have to
+	static void Run(const TArray<FString>& Args, UWorld* World)
+	{
+		UWalkableSurfaceCache* surfaceCache = World != NULL ? World->GetSubsystem<UWalkableSurfaceCache>() : NULL;
+		APawn* playerPawn = UGameplayStatics::GetPlayerPawn(World, 0);
+
+		if (surfaceCache == NULL || playerPawn == NULL)
+		{
+			UE_LOG(LogWalkableSurface, Warning, TEXT("WalkableSurface.Bake needs a game world with a player"));
+			return;
+		}
+
+		const float radius = Args.Num() > 0 ? FCString::Atof(*Args[0]) : 2000.0f;
+
+		const double startTime = FPlatformTime::Seconds();
+		const int32 numTraced = surfaceCache->BakeArea(playerPawn->GetActorLocation(), radius);
+		const double bakeMs = (FPlatformTime::Seconds() - startTime) * 1000.0;
+
+		UE_LOG(LogWalkableSurface, Display, TEXT("Walkable surface bake: %d cells traced within %.0f units in %.3f ms, %d regions cached"),
+			numTraced, radius, bakeMs, surfaceCache->getNumRegions());
+	}
+
+	static FAutoConsoleCommandWithWorldAndArgs BakeCommand(
+		TEXT("WalkableSurface.Bake"),
+		TEXT("Traces the walkable surface cache around the player. Usage: WalkableSurface.Bake [radius=2000]"),
+		FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&Run));
+}
@@ -0,0 +1,117 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "WalkableSurfaceCache.generated.h"
+
+/** height and slope of the ground under one grid cell */
+struct FWalkableSurfaceCell
+{
+	FWalkableSurfaceCell() : height(0.0f), sampleHeight(0.0f), normalZ(0.0f), isSampled(false), hasSurface(false) {}
+
+	// height of the ground at the centre of the cell
+	float height;
+
+	// height the cell was traced from
+	float sampleHeight;
+
+	// up component of the ground normal, 1 is flat
+	float normalZ;
+
+	// false until the cell has been traced
+	bool isSampled;
+
+	// false if the trace under the cell found nothing to stand on
+	bool hasSurface;
+};
+
+/** fixed size block of cells, regions are only added once something looks them up */
+struct FWalkableSurfaceRegion
+{
+	TArray<FWalkableSurfaceCell> cells;
+};
+
+/**
+ * World subsystem that caches the height and slope of the static ground in a 2D grid
+ * cells are traced the first time they are looked up and reused after that
+ * so checking every point under a Sage Wall is a lookup per point instead of a trace per point every frame
+ */
+UCLASS(config=Game)
+class COURSEWORKCODE_API UWalkableSurfaceCache : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	UWalkableSurfaceCache();
+
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	// finds the ground under the location, tracing it if the cell hasn't been sampled yet
+	// the cached result is used if the location is within the step height of the ground or of the height the cell was traced from
+	// so ground too far below to place on is kept as a negative result, and only a floor above or below traces the cell again
+	// returns false if there is no ground under the location
+	bool GetSurface(const FVector& location, FWalkableSurfaceCell& outCell);
+
+	// true if a surface with this normal is flat enough to place on
+	bool IsWalkableNormal(const FVector& normal) const;
+
+	// true if every point has walkable ground within the step height of the base height
+	bool IsFootprintWalkable(const TArray<FVector>& footprintPoints, float baseHeight);
+
+	// traces every cell within the radius of the centre that hasn't been sampled yet
+	// returns the number of cells traced
+	int32 BakeArea(const FVector& centre, float radius);
+
+	// forgets every cell in the box so they are traced again, used when walls and cubes are placed or removed
+	void InvalidateArea(const FBox& area);
+
+	// forgets every cell
+	void Reset();
+
+	// size of a cell along each side
+	float getCellSize() const { return cellSize; }
+
+	// number of regions that have been added to the grid
+	int32 getNumRegions() const { return regions.Num(); }
+
+protected:
+
+	/** size of a cell along each side, every point inside a cell shares its height and slope */
+	UPROPERTY(config)
+	float cellSize;
+
+	/** number of cells along each side of a region */
+	UPROPERTY(config)
+	int32 regionCells;
+
+	/** steepest slope in degrees the wall can be placed on */
+	UPROPERTY(config)
+	float maxWalkableSlope;
+
+	/** largest height difference between the placement point and any point under the wall */
+	UPROPERTY(config)
+	float maxStepHeight;
+
+	/** how far above and below the location the ground is traced for */
+	UPROPERTY(config)
+	float traceHalfHeight;
+
+	// lowest normal Z that counts as walkable, worked out from the max walkable slope
+	float minWalkableNormalZ;
+
+	// regions of the grid, by region coordinate
+	TMap<FIntPoint, FWalkableSurfaceRegion> regions;
+
+	// finds the cell containing the location, adding its region if needed
+	FWalkableSurfaceCell& FindOrAddCell(const FVector& location);
+
+	// traces straight down through the centre of the cell and stores the result
+	void SampleCell(FWalkableSurfaceCell& cell, const FIntPoint& cellCoord, float traceHeight);
+
+	// cell coordinate containing the location
+	FIntPoint GetCellCoord(const FVector& location) const;
+};